@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alias.h"
+
+//##############################################################################
+//# Vose alias tables.
+//##############################################################################
+
+
+//==============================================================================
+// (Re)builds at for the tiles in set, each drawn with probability proportional
+// to weight[tile]. Every weight in set must be positive. The table's storage
+// is reused when it is large enough.
+//==============================================================================
+
+void alias_build(AliasTable *at, const uint64_t *set, int words, const double *weight) {
+    double *p;
+    int    *small, *large;
+    int     n, i, t, s, l, ns = 0, nl = 0;
+
+    n = bitset_count(set, words);
+    alias_reserve(at, n, words);
+    at->n = n;
+    memcpy(at->set, set, sizeof(uint64_t) * words);
+
+    p     = malloc(sizeof(double) * n);
+    small = malloc(sizeof(int) * n);
+    large = malloc(sizeof(int) * n);
+    if(!p || !small || !large) {
+        printf("Unable to allocate alias table.\n");
+        abort();
+    }
+
+    at->weight = 0.0;
+    for(i = 0, t = bitset_first(set, words); t >= 0; i++, t = bitset_next(set, words, t + 1)) {
+        at->tile[i] = t;
+        at->weight += weight[t];
+    }
+
+    // Scale to a mean of 1 and pair each underfull column with an overfull one.
+
+    for(i = 0; i < n; i++) {
+        p[i] = weight[at->tile[i]] * n / at->weight;
+        if(p[i] < 1.0)
+            small[ns++] = i;
+        else
+            large[nl++] = i;
+    }
+
+    while(ns && nl) {
+        s = small[--ns];
+        l = large[nl - 1];
+
+        at->cut[s]   = (uint32_t)(p[s] * 4294967296.0);
+        at->alias[s] = at->tile[l];
+
+        p[l] -= 1.0 - p[s];
+        if(p[l] < 1.0) {
+            nl--;
+            small[ns++] = l;
+        }
+    }
+
+    // Whatever is left is full up to rounding error.
+
+    while(nl) {
+        l = large[--nl];
+        at->cut[l]   = UINT32_MAX;
+        at->alias[l] = at->tile[l];
+    }
+    while(ns) {
+        s = small[--ns];
+        at->cut[s]   = UINT32_MAX;
+        at->alias[s] = at->tile[s];
+    }
+
+    free(p);
+    free(small);
+    free(large);
+}
+
+
+//==============================================================================
+// Releases the table's storage.
+//==============================================================================
+
+void alias_free(AliasTable *at) {
+    free(at->tile);
+    free(at->alias);
+    free(at->cut);
+    free(at->set);
+    memset(at, 0, sizeof(AliasTable));
+}
+
+
+//==============================================================================
+// Makes sure that at has room for n columns and a set of words words. The
+// contents are undefined if the storage had to grow.
+//==============================================================================
+
+void alias_reserve(AliasTable *at, int n, int words) {
+    if(n <= at->size && at->set)
+        return;
+
+    free(at->tile);
+    free(at->alias);
+    free(at->cut);
+    free(at->set);
+    at->size  = n;
+    at->tile  = malloc(sizeof(int) * n);
+    at->alias = malloc(sizeof(int) * n);
+    at->cut   = malloc(sizeof(uint32_t) * n);
+    at->set   = malloc(sizeof(uint64_t) * words);
+    if(!at->tile || !at->alias || !at->cut || !at->set) {
+        printf("Unable to allocate alias table.\n");
+        abort();
+    }
+}
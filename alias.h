@@ -0,0 +1,46 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bitset.h"
+
+//##############################################################################
+//# Vose alias tables for O(1) weighted sampling from a set of tiles. Building
+//# a table is O(n); each sample then takes a single 64-bit random draw: the
+//# high word picks a column and the low word decides between the column's own
+//# tile and its alias.
+//##############################################################################
+
+#define ALIAS_MIN_FILL 0.5       // rebuild once a domain holds less than this share of its table's weight
+
+typedef struct {
+    int       n;                 // number of tiles in the table, 0 if not built
+    double    weight;            // total weight of those tiles
+    int      *tile;              // tile in each column
+    int      *alias;             // alternative tile in each column
+    uint32_t *cut;               // keep tile[i] if the low word of the draw is below cut[i]
+    uint64_t *set;               // bitset of the tiles in the table
+    int       size;              // allocated columns
+} AliasTable;
+
+
+//==============================================================================
+// Returns the tile selected by the 64-bit random value r.
+//==============================================================================
+
+static inline int alias_sample(const AliasTable *at, uint64_t r) {
+    int i = (int)(((r >> 32) * (uint64_t)at->n) >> 32);
+
+    return (uint32_t)r < at->cut[i] ? at->tile[i] : at->alias[i];
+}
+
+
+// Prototypes ==================================================================
+
+void alias_build(AliasTable *at, const uint64_t *set, int words, const double *weight);
+void alias_free(AliasTable *at);
+void alias_reserve(AliasTable *at, int n, int words);
+
+#endif // ALIAS_H
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "band.h"
+#include "lattice.h"
+#include "region.h"
+#include "render.h"
+#include "runstats.h"
+
+//##############################################################################
+//# Streaming band solver.
+//##############################################################################
+
+
+//==============================================================================
+// Copies rows r0..r0+nrows-1 of the assignment in tiles, whose first loaded
+// row is first, onto the end of bd->band and records their pixel extent. The
+// last row is also kept in bd->above for pinning, and the row it replaces in
+// bd->pinned for band_uncommit(). Returns boolean success.
+//==============================================================================
+
+bool band_commit(Band *bd, int *tiles, int first, int r0, int nrows) {
+    BandRows *br;
+    Tile     *tile;
+    int       i, n = nrows * lattice.width, x, y;
+
+    bd->band = realloc(bd->band, sizeof(BandRows) * (bd->nbands + 1));
+    if(!bd->band) {
+        printf("Unable to allocate band.\n");
+        abort();
+    }
+    br = bd->band + bd->nbands++;
+
+    br->first  = r0;
+    br->nrows  = nrows;
+    br->tiles  = malloc(sizeof(int) * n);
+    br->top    = INT32_MAX;
+    br->bottom = INT32_MIN;
+    if(!br->tiles) {
+        printf("Unable to allocate band.\n");
+        abort();
+    }
+    memcpy(br->tiles, tiles + (size_t)(r0 - first) * lattice.width, sizeof(int) * n);
+    memcpy(bd->pinned, bd->above, sizeof(int) * lattice.width);
+    memcpy(bd->above, br->tiles + (size_t)(nrows - 1) * lattice.width, sizeof(int) * lattice.width);
+
+    for(i = 0; i < n; i++) {
+        tile = config.tile.ary[br->tiles[i]];
+        lattice_position(i % lattice.width, r0 + i / lattice.width, &x, &y);
+        if(y - tile->y_offset < br->top)
+            br->top = y - tile->y_offset;
+        if(y - tile->y_offset + tile->height > br->bottom)
+            br->bottom = y - tile->y_offset + tile->height;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Takes back the last band that band_commit() added, which must not have been
+// rendered yet, and restores bd->above to the row that band was pinned to.
+//==============================================================================
+
+void band_uncommit(Band *bd) {
+    free(bd->band[--bd->nbands].tiles);
+    memcpy(bd->above, bd->pinned, sizeof(int) * lattice.width);
+}
+
+
+//==============================================================================
+// Writes every strip that the committed bands are complete for, then drops
+// the bands that no later strip reaches. The last committed band may still be
+// taken back by band_uncommit(), so it counts as unsolved. A band that has yet
+// to be solved starts at least bd->up pixels above its first row, which
+// bounds what it can still add. If last is set, no more bands follow and all
+// remaining strips are written. Returns boolean success.
+//==============================================================================
+
+bool band_render(Band *bd, bool last) {
+    BandRows *br;
+    int       next, x, y, i;
+
+    next = INT32_MAX;
+    if(!last && bd->nbands) {
+        br = bd->band + bd->nbands - 1;
+        lattice_position(0, br->first, &x, &y);
+        next = y - bd->up;
+    }
+
+    while(bd->strip * bd->strip_height < config.image_height
+            && (bd->strip + 1) * bd->strip_height <= next) {
+        if(bd->pattern && !band_strip(bd, bd->strip))
+            return false;
+        bd->strip++;
+
+        for(i = 0; i < bd->nbands && bd->band[i].bottom <= bd->strip * bd->strip_height; i++)
+            free(bd->band[i].tiles);
+        memmove(bd->band, bd->band + i, sizeof(BandRows) * (bd->nbands - i));
+        bd->nbands -= i;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Solves the lattice band by band, rows rows at a time with lookahead more
+// below, and writes the output strips to the files that pattern yields, if
+// it is not NULL. The config must have a lattice that has not been loaded, and
+// compat_build() and, with a pattern, render_sprites() must have been run.
+// Band b is solved with its own seed derived from opt->seed and b. If it has
+// no solution, band b - 1 is solved once more, with random values and a seed
+// from another stream, before giving up, since the row it left for band b may
+// be what rules out every solution. stats receives the counters summed over all bands. Returns
+// boolean success.
+//==============================================================================
+
+bool band_run(SolverOptions *opt, int nworkers, int nthreads, int rows, int lookahead, char *pattern, SolverStats *stats) {
+    Band          bd;
+    SolverOptions bopt;
+    SolverStats   st;
+    PhaseClock    clk;
+    Tile         *tile;
+    int          *pin, *tiles;
+    int           b, t, r0, first, last, n, i, res, retry = -1;
+    bool          ok = true;
+
+    if(lattice.type < 0) {
+        fprintf(stderr, "Solving in bands requires a lattice entry in the config file.\n");
+        return false;
+    }
+
+    memset(&bd, 0, sizeof(Band));
+    bd.opt          = *opt;
+    bd.nworkers     = nworkers;
+    bd.nthreads     = nthreads;
+    bd.rows         = rows;
+    bd.lookahead    = lookahead;
+    bd.pattern      = pattern;
+    bd.strip_height = rows * lattice.spacing_y;
+    for(t = 0; t < compat.ntiles; t++) {
+        tile = config.tile.ary[t];
+        if(tile->y_offset > bd.up)
+            bd.up = tile->y_offset;
+    }
+    if(pattern && config.bg_image_filename) {
+        runstats_start(&clk, CLOCK_THREAD_CPUTIME_ID);
+        ok = render_load(&bd.bg, config.bg_image_filename);
+        runstats_stop(&clk, PHASE_SPRITES);
+        if(!ok)
+            return false;
+    }
+
+    n        = (rows + lookahead + 1) * lattice.width;
+    pin      = malloc(sizeof(int) * n);
+    tiles    = malloc(sizeof(int) * n);
+    bd.above  = malloc(sizeof(int) * lattice.width);
+    bd.pinned = malloc(sizeof(int) * lattice.width);
+    if(!pin || !tiles || !bd.above || !bd.pinned) {
+        printf("Unable to allocate band.\n");
+        abort();
+    }
+
+    for(b = 0, r0 = 0; ok && r0 < lattice.height; b++, r0 += rows) {
+        first = r0 ? r0 - 1 : 0;
+        last  = r0 + rows + lookahead < lattice.height ? r0 + rows + lookahead : lattice.height;
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        ok = lattice_generate(first, last - first);
+        runstats_stop(&clk, PHASE_PARSE);
+        if(!ok)
+            break;
+
+        // Pin the row above to the tiles it was committed with.
+
+        for(i = 0; i < config.vert.used; i++)
+            pin[i] = -1;
+        if(r0)
+            memcpy(pin, bd.above, sizeof(int) * lattice.width);
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        region_build(r0 ? pin : NULL);
+        runstats_stop(&clk, PHASE_SETUP);
+
+        bopt = bd.opt;
+        bopt.seed = rng_u64(opt->seed, BAND_RNG_STREAM, b);
+        if(b == retry) {
+            bopt.seed = rng_u64(opt->seed, BAND_RETRY_STREAM, b);
+            bopt.random_values = true;
+        }
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        res = region_solve(&bopt, nworkers, nthreads, tiles, &st);
+        runstats_stop(&clk, PHASE_SOLVE);
+        solver_add_stats(&bd.stats, &st);
+        runstats_solver(&st);
+        if(res == SOLVE_UNSAT && r0 && retry < b - 1) {
+            fprintf(stderr, "Rows %d to %d have no solution that fits the rows above them; solving rows %d to %d again.\n",
+                r0, last - 1, r0 - rows, r0 - 1);
+            band_uncommit(&bd);
+            retry = b - 1;
+            b  -= 2;
+            r0 -= 2 * rows;
+            continue;
+        }
+        if(res != SOLVE_OK) {
+            fprintf(stderr, "Rows %d to %d have no solution that fits the rows above them.\n", r0, last - 1);
+            ok = false;
+            break;
+        }
+
+        band_commit(&bd, tiles, first, r0, (r0 + rows < lattice.height ? r0 + rows : lattice.height) - r0);
+        ok = band_render(&bd, r0 + rows >= lattice.height);
+    }
+
+    if(ok && r0 >= lattice.height)
+        ok = band_render(&bd, true);
+
+    for(i = 0; i < bd.nbands; i++)
+        free(bd.band[i].tiles);
+    free(bd.band);
+    free(bd.above);
+    free(bd.pinned);
+    free(bd.bg.pixels);
+    free(pin);
+    free(tiles);
+    region_free();
+
+    *stats = bd.stats;
+    return ok;
+}
+
+
+//==============================================================================
+// Renders strip k, i.e., pixel rows k * bd->strip_height onward, from the
+// committed bands and writes it to the file that bd->pattern yields for k.
+// Tiles are drawn in row order, as render_composite() would. Returns boolean
+// success.
+//==============================================================================
+
+bool band_strip(Band *bd, int k) {
+    Bitmap     canvas;
+    BandRows  *br;
+    Tile      *tile;
+    PhaseClock clk;
+    char       fname[4096];
+    unsigned   i;
+    bool       bres;
+    int        y0 = k * bd->strip_height, j, v, x, y;
+
+    runstats_start(&clk, CLOCK_THREAD_CPUTIME_ID);
+
+    canvas.width  = config.image_width;
+    canvas.height = config.image_height - y0 < bd->strip_height ? config.image_height - y0 : bd->strip_height;
+    canvas.pixels = malloc(sizeof(Pixel) * canvas.width * canvas.height);
+    if(!canvas.pixels) {
+        printf("Unable to allocate strip canvas.\n");
+        abort();
+    }
+
+    for(i = 0; i < canvas.width * canvas.height; i++)
+        canvas.pixels[i] = config.bgcolor;
+    if(bd->bg.pixels)
+        render_blit(&canvas, &bd->bg, 0, 0, bd->bg.width, bd->bg.height, 0, -y0);
+
+    for(j = 0; j < bd->nbands; j++) {
+        br = bd->band + j;
+        if(br->bottom <= y0 || br->top >= y0 + (int)canvas.height)
+            continue;
+
+        for(v = 0; v < br->nrows * lattice.width; v++) {
+            tile = config.tile.ary[br->tiles[v]];
+            lattice_position(v % lattice.width, br->first + v / lattice.width, &x, &y);
+            render_blit(&canvas, tile->sprite, tile->orientation * tile->width, 0, tile->width, tile->height,
+                x - tile->x_offset, y - tile->y_offset - y0);
+        }
+    }
+
+    runstats_stop(&clk, PHASE_COMPOSITE);
+
+    snprintf(fname, sizeof(fname), bd->pattern, k);
+    bres = render_encode(&canvas, fname);
+    free(canvas.pixels);
+
+    return bres;
+}
@@ -0,0 +1,67 @@
+#ifndef BAND_H
+#define BAND_H
+
+#include <stdbool.h>
+
+#include "rng.h"
+#include "solver.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Streaming solve of a generated lattice in horizontal bands. Each band is
+//# loaded into config.vert together with the last committed row above it,
+//# which is pinned, and a few lookahead rows below it, which are solved but
+//# thrown away so that the band does not paint itself into a corner. The
+//# committed rows are kept only until every output strip they reach has been
+//# rendered, so memory depends on the lattice width, not its height.
+//#
+//# The output image, config.image_width by config.image_height pixels, is
+//# cut into strips of one band's height, and strip k is written to the file
+//# that the --out pattern yields for k. Stacked, the strips show exactly what
+//# rendering the whole lattice at once would.
+//#
+//# If a band has no solution that fits the row above it, the band before it
+//# is taken back and solved once more with a different seed, which is why a
+//# strip is only written once the band after the ones it shows is solved.
+//##############################################################################
+
+#define BAND_LOOKAHEAD    2                      // default rows solved below each band
+#define BAND_RNG_STREAM   (RNG_STREAM_BASE)      // rng.h stream for per-band seeds
+#define BAND_RETRY_STREAM (RNG_STREAM_BASE + 3)  // rng.h stream for the seeds of retried bands
+
+typedef struct {             // Committed rows of one band, kept for rendering
+    int   first;                 // first row
+    int   nrows;                 // number of rows
+    int  *tiles;                 // nrows * lattice.width tiles, row by row
+    int   top;                   // first pixel row any of its sprites covers
+    int   bottom;                // pixel row just below all of its sprites
+} BandRows;
+
+typedef struct {             // State of a streaming solve
+    SolverOptions opt;           // base options; each band gets its own seed
+    int           nworkers;      // portfolio size
+    int           nthreads;
+    int           rows;          // rows per band
+    int           lookahead;     // extra rows solved below each band
+    char         *pattern;       // output filename pattern, or NULL for none
+    int           strip;         // next strip to render
+    int           strip_height;  // pixel rows per strip
+    int           up;            // greatest extent of any tile above its center
+    BandRows     *band;          // committed bands still needed, oldest first
+    int          *above;         // tiles of the last committed row
+    int          *pinned;        // tiles of the row the last committed band was pinned to
+    int           nbands;
+    Bitmap        bg;            // decoded background image, if any
+    SolverStats   stats;         // counters summed over all bands
+} Band;
+
+
+// Prototypes ==================================================================
+
+bool band_commit(Band *bd, int *tiles, int first, int r0, int nrows);
+bool band_render(Band *bd, bool last);
+bool band_run(SolverOptions *opt, int nworkers, int nthreads, int rows, int lookahead, char *pattern, SolverStats *stats);
+bool band_strip(Band *bd, int k);
+void band_uncommit(Band *bd);
+
+#endif // BAND_H
@@ -0,0 +1,110 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "batch.h"
+#include "region.h"
+#include "render.h"
+#include "resolve.h"
+#include "runstats.h"
+#include "workpool.h"
+
+//##############################################################################
+//# Batch generation mode.
+//##############################################################################
+
+
+//==============================================================================
+// Generates count images on nthreads threads, each with a portfolio of
+// nworkers solvers per region. Image k is solved with seed opt->seed + k and
+// random value ordering, and written to the filename that pattern yields for
+// k. Images are solved side by side, and with fewer images than threads, the
+// spare threads go to their portfolios, so the images themselves do not
+// depend on nthreads. The config must already be parsed, compat_build() and
+// region_build() run and the sprites loaded with render_init(). Returns the
+// number of images that could not be produced.
+//==============================================================================
+
+int batch_run(SolverOptions *opt, int nworkers, int nthreads, int count, char *pattern) {
+    Batch batch;
+
+    batch.opt      = *opt;
+    batch.nworkers = nworkers;
+    batch.nthreads = nthreads > count ? nthreads / count : 1;
+    batch.pattern  = pattern;
+    batch.failed   = 0;
+    batch.opt.random_values = true;
+
+    workpool_run(nthreads, count, batch_job, &batch);
+
+    return batch.failed;
+}
+
+
+//==============================================================================
+// Worker pool job: solves variant job with a portfolio per region and renders
+// it. A variant that runs out of budget is rendered with its gaps filled.
+//==============================================================================
+
+void batch_job(int job, void *ctx) {
+    Batch        *batch = ctx;
+    SolverOptions opt   = batch->opt;
+    SolverStats   stats;
+    PhaseClock    clk;
+    char          fname[4096];
+    int          *tiles;
+    int           res;
+
+    snprintf(fname, sizeof(fname), batch->pattern, job);
+    opt.seed += job;
+
+    tiles = malloc(sizeof(int) * config.vert.used);
+    if(!tiles) {
+        printf("Unable to allocate tile assignment.\n");
+        abort();
+    }
+
+    runstats_start(&clk, CLOCK_THREAD_CPUTIME_ID);
+    res = region_solve(&opt, batch->nworkers, batch->nthreads, tiles, &stats);
+    runstats_stop(&clk, PHASE_SOLVE);
+    runstats_solver(&stats);
+    if(res == SOLVE_BUDGET)
+        fprintf(stderr, "Out of budget for '%s', filled %d vertices with the best fitting tiles.\n", fname, solution_fill(tiles));
+    if(res != SOLVE_OK && res != SOLVE_BUDGET) {
+        fprintf(stderr, "No solution for '%s'.\n", fname);
+        __atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+    } else if(!render_write(fname, tiles)) {
+        __atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+    }
+
+    free(tiles);
+}
+
+
+//==============================================================================
+// Returns true if pat is safe to use as an output pattern, i.e., it holds
+// exactly one integer conversion (flags and width allowed) and otherwise only
+// literal text and "%%".
+//==============================================================================
+
+bool batch_valid_pattern(char *pat) {
+    char *p;
+    int   cnt = 0;
+
+    for(p = pat; *p; p++) {
+        if(*p != '%')
+            continue;
+        p++;
+        if(*p == '%')
+            continue;
+        while(*p && strchr("-+ 0#", *p))
+            p++;
+        while(isdigit((unsigned char)*p))
+            p++;
+        if(!*p || !strchr("diuxXo", *p))
+            return false;
+        cnt++;
+    }
+
+    return cnt == 1;
+}
@@ -0,0 +1,28 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+
+#include "solver.h"
+
+//##############################################################################
+//# Batch generation: many variants of one parsed config, each solved with its
+//# own seed and rendered to its own file, spread over a worker pool.
+//##############################################################################
+
+typedef struct {             // Shared state for batch generation jobs
+    SolverOptions opt;           // base options; each job adds its number to opt.seed
+    int           nworkers;      // portfolio size per region
+    int           nthreads;      // threads per job
+    char         *pattern;       // printf-style output filename pattern
+    int           failed;        // number of jobs that produced no image
+} Batch;
+
+
+// Prototypes ==================================================================
+
+void batch_job(int job, void *ctx);
+int  batch_run(SolverOptions *opt, int nworkers, int nthreads, int count, char *pattern);
+bool batch_valid_pattern(char *pat);
+
+#endif // BATCH_H
@@ -0,0 +1,319 @@
+#include "bitset.h"
+
+#if defined(__x86_64__)
+#define BITSET_X86
+#include <immintrin.h>
+#endif
+
+//##############################################################################
+//# Multi-word bitset kernels with runtime dispatch. The scalar kernels work
+//# everywhere; on x86-64, bitset_init() switches to SSE2 or AVX2 kernels, built
+//# with per-function target attributes so that the rest of the program needs
+//# no special compiler flags. Every kernel accepts any word count and finishes
+//# the words that do not fill a whole vector one at a time.
+//##############################################################################
+
+
+//==============================================================================
+// Scalar kernels.
+//==============================================================================
+
+static void intersect_scalar(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        dst[i] &= src[i];
+}
+
+static void subtract_scalar(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        dst[i] &= ~src[i];
+}
+
+static void unite_scalar(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        dst[i] |= src[i];
+}
+
+static int count_scalar(const uint64_t *b, int words) {
+    int i, cnt = 0;
+
+    for(i = 0; i < words; i++)
+        cnt += __builtin_popcountll(b[i]);
+    return cnt;
+}
+
+static int first_scalar(const uint64_t *b, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        if(b[i])
+            return (i << 6) + __builtin_ctzll(b[i]);
+    return -1;
+}
+
+static bool empty_scalar(const uint64_t *b, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        if(b[i])
+            return false;
+    return true;
+}
+
+static bool subset_scalar(const uint64_t *a, const uint64_t *b, int words) {
+    int i;
+
+    for(i = 0; i < words; i++)
+        if(a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+BitsetKernels bitset_kernels = {
+    "scalar", intersect_scalar, subtract_scalar, unite_scalar,
+    count_scalar, first_scalar, empty_scalar, subset_scalar
+};
+
+
+#ifdef BITSET_X86
+
+//==============================================================================
+// Scalar popcount using the POPCNT instruction, which the SSE2 and AVX2
+// kernel sets use for the words that do not fill a vector.
+//==============================================================================
+
+__attribute__((target("popcnt")))
+static int count_popcnt(const uint64_t *b, int words) {
+    int i, cnt = 0;
+
+    for(i = 0; i < words; i++)
+        cnt += __builtin_popcountll(b[i]);
+    return cnt;
+}
+
+
+//==============================================================================
+// SSE2 kernels, two words per vector.
+//==============================================================================
+
+__attribute__((target("sse2")))
+static void intersect_sse2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)(dst + i)), _mm_loadu_si128((const __m128i *)(src + i))));
+    for(; i < words; i++)
+        dst[i] &= src[i];
+}
+
+__attribute__((target("sse2")))
+static void subtract_sse2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_andnot_si128(
+            _mm_loadu_si128((const __m128i *)(src + i)), _mm_loadu_si128((const __m128i *)(dst + i))));
+    for(; i < words; i++)
+        dst[i] &= ~src[i];
+}
+
+__attribute__((target("sse2")))
+static void unite_sse2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(
+            _mm_loadu_si128((const __m128i *)(dst + i)), _mm_loadu_si128((const __m128i *)(src + i))));
+    for(; i < words; i++)
+        dst[i] |= src[i];
+}
+
+__attribute__((target("sse2")))
+static int first_sse2(const uint64_t *b, int words) {
+    __m128i zero = _mm_setzero_si128();
+    int     i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(b + i)), zero)) != 0xFFFF)
+            break;
+    for(; i < words; i++)
+        if(b[i])
+            return (i << 6) + __builtin_ctzll(b[i]);
+    return -1;
+}
+
+__attribute__((target("sse2")))
+static bool empty_sse2(const uint64_t *b, int words) {
+    __m128i acc = _mm_setzero_si128();
+    int     i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(b + i)));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF)
+        return false;
+    for(; i < words; i++)
+        if(b[i])
+            return false;
+    return true;
+}
+
+__attribute__((target("sse2")))
+static bool subset_sse2(const uint64_t *a, const uint64_t *b, int words) {
+    __m128i acc = _mm_setzero_si128();
+    int     i;
+
+    for(i = 0; i + 2 <= words; i += 2)
+        acc = _mm_or_si128(acc, _mm_andnot_si128(
+            _mm_loadu_si128((const __m128i *)(b + i)), _mm_loadu_si128((const __m128i *)(a + i))));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF)
+        return false;
+    for(; i < words; i++)
+        if(a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+
+//==============================================================================
+// AVX2 kernels, four words per vector. The popcount looks up the bit count of
+// each nibble with a byte shuffle and sums the bytes with SAD, which beats
+// POPCNT once there are several vectors' worth of words.
+//==============================================================================
+
+__attribute__((target("avx2")))
+static void intersect_avx2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 4 <= words; i += 4)
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)(dst + i)), _mm256_loadu_si256((const __m256i *)(src + i))));
+    for(; i < words; i++)
+        dst[i] &= src[i];
+}
+
+__attribute__((target("avx2")))
+static void subtract_avx2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 4 <= words; i += 4)
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_andnot_si256(
+            _mm256_loadu_si256((const __m256i *)(src + i)), _mm256_loadu_si256((const __m256i *)(dst + i))));
+    for(; i < words; i++)
+        dst[i] &= ~src[i];
+}
+
+__attribute__((target("avx2")))
+static void unite_avx2(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    for(i = 0; i + 4 <= words; i += 4)
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(
+            _mm256_loadu_si256((const __m256i *)(dst + i)), _mm256_loadu_si256((const __m256i *)(src + i))));
+    for(; i < words; i++)
+        dst[i] |= src[i];
+}
+
+__attribute__((target("avx2,popcnt")))
+static int count_avx2(const uint64_t *b, int words) {
+    __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i acc = _mm256_setzero_si256();
+    __m256i v, cnt;
+    int     i, total;
+
+    for(i = 0; i + 4 <= words; i += 4) {
+        v   = _mm256_loadu_si256((const __m256i *)(b + i));
+        cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                              _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+    }
+
+    total = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+          + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+    for(; i < words; i++)
+        total += __builtin_popcountll(b[i]);
+    return total;
+}
+
+__attribute__((target("avx2")))
+static int first_avx2(const uint64_t *b, int words) {
+    __m256i v;
+    int     i;
+
+    for(i = 0; i + 4 <= words; i += 4) {
+        v = _mm256_loadu_si256((const __m256i *)(b + i));
+        if(!_mm256_testz_si256(v, v))
+            break;
+    }
+    for(; i < words; i++)
+        if(b[i])
+            return (i << 6) + __builtin_ctzll(b[i]);
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static bool empty_avx2(const uint64_t *b, int words) {
+    __m256i v;
+    int     i;
+
+    for(i = 0; i + 4 <= words; i += 4) {
+        v = _mm256_loadu_si256((const __m256i *)(b + i));
+        if(!_mm256_testz_si256(v, v))
+            return false;
+    }
+    for(; i < words; i++)
+        if(b[i])
+            return false;
+    return true;
+}
+
+__attribute__((target("avx2")))
+static bool subset_avx2(const uint64_t *a, const uint64_t *b, int words) {
+    int i;
+
+    // testc yields 1 if every bit set in its second operand is set in its
+    // first.
+
+    for(i = 0; i + 4 <= words; i += 4)
+        if(!_mm256_testc_si256(_mm256_loadu_si256((const __m256i *)(b + i)),
+                               _mm256_loadu_si256((const __m256i *)(a + i))))
+            return false;
+    for(; i < words; i++)
+        if(a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+#endif // BITSET_X86
+
+
+//==============================================================================
+// Points bitset_kernels at the widest kernels the CPU supports. Until this
+// is called, the scalar kernels are used. Idempotent.
+//==============================================================================
+
+void bitset_init(void) {
+#ifdef BITSET_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        bitset_kernels = (BitsetKernels) {
+            "avx2", intersect_avx2, subtract_avx2, unite_avx2,
+            count_avx2, first_avx2, empty_avx2, subset_avx2
+        };
+    } else if(__builtin_cpu_supports("sse2")) {
+        bitset_kernels = (BitsetKernels) {
+            "sse2", intersect_sse2, subtract_sse2, unite_sse2,
+            __builtin_cpu_supports("popcnt") ? count_popcnt : count_scalar,
+            first_sse2, empty_sse2, subset_sse2
+        };
+    }
+#endif
+}
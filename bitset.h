@@ -0,0 +1,196 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+//##############################################################################
+//# Fixed-width bitsets stored as arrays of uint64_t words. The number of words
+//# is supplied by the caller on every operation; use BITSET_WORDS() to size
+//# them.
+//#
+//# Bitsets of BITSET_KERNEL_WORDS words or more, i.e., domains over large tile
+//# sets, are handed to the kernels in bitset_kernels, which bitset_init()
+//# points at the widest SIMD implementation the CPU supports; see bitset.c.
+//# Shorter ones are handled inline, where a call would cost more than the loop.
+//##############################################################################
+
+#define BITSET_WORDS(nbits) (((nbits) + 63) / 64)
+
+#define BITSET_KERNEL_WORDS 4    // shortest bitset, in words, passed to the kernels
+
+typedef struct {             // Multi-word bitset kernels of one instruction set
+    char *name;
+    void (*intersect)(uint64_t *dst, const uint64_t *src, int words);   // dst &= src
+    void (*subtract)(uint64_t *dst, const uint64_t *src, int words);    // dst &= ~src
+    void (*unite)(uint64_t *dst, const uint64_t *src, int words);       // dst |= src
+    int  (*count)(const uint64_t *b, int words);
+    int  (*first)(const uint64_t *b, int words);
+    bool (*empty)(const uint64_t *b, int words);
+    bool (*subset)(const uint64_t *a, const uint64_t *b, int words);
+} BitsetKernels;
+
+extern BitsetKernels bitset_kernels;
+
+
+//==============================================================================
+// Sets, clears, or tests bit i.
+//==============================================================================
+
+static inline void bitset_set(uint64_t *b, int i) {
+    b[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void bitset_clear(uint64_t *b, int i) {
+    b[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+static inline bool bitset_test(const uint64_t *b, int i) {
+    return (b[i >> 6] >> (i & 63)) & 1;
+}
+
+
+//==============================================================================
+// Sets the first nbits bits and clears the rest of the words.
+//==============================================================================
+
+static inline void bitset_fill(uint64_t *b, int nbits) {
+    int words = BITSET_WORDS(nbits);
+
+    memset(b, 0xFF, words * sizeof(uint64_t));
+    if(nbits & 63)
+        b[words - 1] = ((uint64_t)1 << (nbits & 63)) - 1;
+}
+
+
+//==============================================================================
+// Returns the number of set bits.
+//==============================================================================
+
+static inline int bitset_count(const uint64_t *b, int words) {
+    int i, cnt = 0;
+
+    if(words >= BITSET_KERNEL_WORDS)
+        return bitset_kernels.count(b, words);
+    for(i = 0; i < words; i++)
+        cnt += __builtin_popcountll(b[i]);
+    return cnt;
+}
+
+
+//==============================================================================
+// Returns the index of the first set bit at or after i, or -1 if there is none.
+//==============================================================================
+
+static inline int bitset_next(const uint64_t *b, int words, int i) {
+    int      w = i >> 6;
+    uint64_t cur;
+
+    if(w >= words)
+        return -1;
+    cur = b[w] & (~(uint64_t)0 << (i & 63));
+    if(!cur && words - w > BITSET_KERNEL_WORDS) {
+        i = bitset_kernels.first(b + w + 1, words - w - 1);
+        return i < 0 ? -1 : ((w + 1) << 6) + i;
+    }
+    while(!cur) {
+        if(++w == words)
+            return -1;
+        cur = b[w];
+    }
+    return (w << 6) + __builtin_ctzll(cur);
+}
+
+static inline int bitset_first(const uint64_t *b, int words) {
+    if(words >= BITSET_KERNEL_WORDS)
+        return bitset_kernels.first(b, words);
+    return bitset_next(b, words, 0);
+}
+
+
+//==============================================================================
+// In-place union: dst |= src.
+//==============================================================================
+
+static inline void bitset_or(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    if(words >= BITSET_KERNEL_WORDS) {
+        bitset_kernels.unite(dst, src, words);
+        return;
+    }
+    for(i = 0; i < words; i++)
+        dst[i] |= src[i];
+}
+
+
+//==============================================================================
+// In-place intersection: dst &= src.
+//==============================================================================
+
+static inline void bitset_and(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    if(words >= BITSET_KERNEL_WORDS) {
+        bitset_kernels.intersect(dst, src, words);
+        return;
+    }
+    for(i = 0; i < words; i++)
+        dst[i] &= src[i];
+}
+
+
+//==============================================================================
+// In-place difference: dst &= ~src.
+//==============================================================================
+
+static inline void bitset_andnot(uint64_t *dst, const uint64_t *src, int words) {
+    int i;
+
+    if(words >= BITSET_KERNEL_WORDS) {
+        bitset_kernels.subtract(dst, src, words);
+        return;
+    }
+    for(i = 0; i < words; i++)
+        dst[i] &= ~src[i];
+}
+
+
+//==============================================================================
+// Returns true if every bit set in a is also set in b.
+//==============================================================================
+
+static inline bool bitset_subset(const uint64_t *a, const uint64_t *b, int words) {
+    int i;
+
+    if(words >= BITSET_KERNEL_WORDS)
+        return bitset_kernels.subset(a, b, words);
+    for(i = 0; i < words; i++)
+        if(a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+
+//==============================================================================
+// Returns true if no bits are set.
+//==============================================================================
+
+static inline bool bitset_empty(const uint64_t *b, int words) {
+    int i;
+
+    if(words >= BITSET_KERNEL_WORDS)
+        return bitset_kernels.empty(b, words);
+    for(i = 0; i < words; i++)
+        if(b[i])
+            return false;
+    return true;
+}
+
+
+// Prototypes ==================================================================
+
+void bitset_init(void);
+
+#endif // BITSET_H
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bucketq.h"
+
+//##############################################################################
+//# Indexed bucket queue.
+//##############################################################################
+
+
+//==============================================================================
+// Allocates an empty queue for nitems items and keys 0..nbuckets-1. Returns
+// boolean success.
+//==============================================================================
+
+bool bucketq_create(BucketQueue *q, int nitems, int nbuckets) {
+    memset(q, 0, sizeof(BucketQueue));
+
+    q->nitems   = nitems;
+    q->nbuckets = nbuckets;
+    q->head = malloc(sizeof(int) * nbuckets);
+    q->next = malloc(sizeof(int) * nitems);
+    q->prev = malloc(sizeof(int) * nitems);
+    q->key  = malloc(sizeof(int) * nitems);
+    if(!q->head || !q->next || !q->prev || !q->key) {
+        bucketq_free(q);
+        return false;
+    }
+
+    memset(q->head, 0xFF, sizeof(int) * nbuckets);
+    memset(q->key, 0xFF, sizeof(int) * nitems);
+    q->min = nbuckets;
+
+    return true;
+}
+
+
+//==============================================================================
+// Releases the queue's storage.
+//==============================================================================
+
+void bucketq_free(BucketQueue *q) {
+    free(q->head);
+    free(q->next);
+    free(q->prev);
+    free(q->key);
+    memset(q, 0, sizeof(BucketQueue));
+}
+
+
+//==============================================================================
+// Unlinks item from its bucket. Does nothing if the item is not queued.
+//==============================================================================
+
+void bucketq_remove(BucketQueue *q, int item) {
+    int k = q->key[item];
+
+    if(k < 0)
+        return;
+
+    if(q->prev[item] >= 0)
+        q->next[q->prev[item]] = q->next[item];
+    else
+        q->head[k] = q->next[item];
+    if(q->next[item] >= 0)
+        q->prev[q->next[item]] = q->prev[item];
+
+    q->key[item] = -1;
+    q->cnt--;
+}
+
+
+//==============================================================================
+// Moves item to the bucket for key, inserting it if necessary. Items are
+// pushed onto the front of their bucket, so the most recently rekeyed item is
+// the first one seen by bucketq_min().
+//==============================================================================
+
+void bucketq_update(BucketQueue *q, int item, int key) {
+    if(q->key[item] == key)
+        return;
+
+    bucketq_remove(q, item);
+
+    q->prev[item] = -1;
+    q->next[item] = q->head[key];
+    if(q->head[key] >= 0)
+        q->prev[q->head[key]] = item;
+    q->head[key] = item;
+    q->key[item] = key;
+    q->cnt++;
+
+    if(key < q->min)
+        q->min = key;
+}
+
+
+//==============================================================================
+// Returns the lowest occupied key, or -1 if the queue is empty. The head of
+// that bucket is then q->head[key].
+//==============================================================================
+
+int bucketq_min(BucketQueue *q) {
+    if(!q->cnt)
+        return -1;
+    while(q->head[q->min] < 0)
+        q->min++;
+    return q->min;
+}
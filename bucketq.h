@@ -0,0 +1,34 @@
+#ifndef BUCKETQ_H
+#define BUCKETQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//##############################################################################
+//# Indexed bucket queue of integer items keyed by small non-negative integers.
+//# Each bucket is a doubly-linked list threaded through per-item arrays, so
+//# rekeying an item is O(1), and finding the minimum is amortized O(1) since
+//# the lower bound only scans upward over empty buckets.
+//##############################################################################
+
+typedef struct {
+    int  nitems;         // number of items, i.e., valid indices are 0..nitems-1
+    int  nbuckets;       // keys run from 0..nbuckets-1
+    int *head;           // first item in each bucket, -1 if empty
+    int *next;           // next item in the same bucket, -1 at the end
+    int *prev;           // previous item in the same bucket, -1 at the head
+    int *key;            // current key of each item, -1 if not queued
+    int  min;            // no bucket below this is occupied
+    int  cnt;            // number of queued items
+} BucketQueue;
+
+
+// Prototypes ==================================================================
+
+bool bucketq_create(BucketQueue *q, int nitems, int nbuckets);
+void bucketq_free(BucketQueue *q);
+int  bucketq_min(BucketQueue *q);
+void bucketq_remove(BucketQueue *q, int item);
+void bucketq_update(BucketQueue *q, int item, int key);
+
+#endif // BUCKETQ_H
@@ -0,0 +1,713 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "region.h"
+#include "rng.h"
+
+//##############################################################################
+//# Solver checkpoints in a memory-mapped state file.
+//##############################################################################
+
+Checkpoint checkpoint;
+
+
+//==============================================================================
+// Returns a hash of everything the saved state depends on: the compat matrix
+// and tile weights, the vertices' neighbors, eligible tiles and order, the
+// tile-count limits, the regions, the solver options and the portfolio size,
+// as well as the layout of the structures that are saved as they are.
+//==============================================================================
+
+static uint64_t checkpoint_fingerprint(SolverOptions *opt, int nworkers) {
+    uint64_t h = 0, bits;
+    size_t   i, n;
+
+    h = rng_mix(h + sizeof(SolverStats));
+    h = rng_mix(h + sizeof(TrailEntry));
+    h = rng_mix(h + sizeof(Level));
+    h = rng_mix(h + (uint64_t)config.vert.used);
+    h = rng_mix(h + (uint64_t)compat.ntiles);
+    h = rng_mix(h + (uint64_t)compat.ndirs);
+    h = rng_mix(h + (uint64_t)regions.nregions);
+    h = rng_mix(h + (uint64_t)opt->select);
+    h = rng_mix(h + opt->seed);
+    h = rng_mix(h + (uint64_t)opt->random_values);
+    h = rng_mix(h + (uint64_t)opt->restart_base);
+    h = rng_mix(h + (uint64_t)opt->restart);
+    h = rng_mix(h + (uint64_t)opt->nogoods);
+    h = rng_mix(h + (uint64_t)nworkers);
+
+    n = (size_t)compat.ntiles * compat.ndirs * compat.words;
+    for(i = 0; i < n; i++)
+        h = rng_mix(h + compat.rows[i]);
+    for(i = 0; i < (size_t)compat.ndirs * compat.words; i++)
+        h = rng_mix(h + compat.border[i]);
+    for(i = 0; i < (size_t)compat.ntiles; i++) {
+        memcpy(&bits, compat.weight + i, sizeof(uint64_t));
+        h = rng_mix(h + bits);
+    }
+
+    n = (size_t)config.vert.used * config.vert.ndirs;
+    for(i = 0; i < n; i++)
+        h = rng_mix(h + (uint32_t)config.vert.neighbor[i]);
+    for(i = 0; i < (size_t)config.vert.used; i++) {
+        h = rng_mix(h + (uint32_t)config.vert.order[i]);
+        h = rng_mix(h + (uint32_t)config.vert.elig_start[i + 1]);
+        h = rng_mix(h + (uint32_t)regions.id[i]);
+    }
+    for(i = 0; i < (size_t)config.vert.elig_start[config.vert.used]; i++)
+        h = rng_mix(h + (uint32_t)config.vert.elig[i]);
+    for(i = 0; i < (size_t)counts.nlimits; i++) {
+        h = rng_mix(h + (uint32_t)counts.limit[i].first);
+        h = rng_mix(h + (uint32_t)counts.limit[i].min);
+        h = rng_mix(h + (uint32_t)counts.limit[i].max);
+    }
+
+    return h;
+}
+
+
+//==============================================================================
+// Copies the size bytes of state file data at map into checkpoint. Returns
+// boolean success.
+//==============================================================================
+
+static bool checkpoint_parse(uint8_t *map, size_t size) {
+    CheckpointHeader  hdr;
+    CheckpointRegion *cr;
+    size_t            pos = sizeof(CheckpointHeader);
+    int               r, i, t;
+
+    memcpy(&hdr, map, sizeof(CheckpointHeader));
+    if(memcmp(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic))) {
+        fprintf(stderr, "'%s' is not a checkpoint file.\n", checkpoint.fname);
+        return false;
+    }
+    if(hdr.fingerprint != checkpoint.fingerprint || hdr.nverts != config.vert.used
+            || hdr.nregions != regions.nregions) {
+        fprintf(stderr, "Checkpoint file '%s' was written for a different config or different options.\n",
+            checkpoint.fname);
+        return false;
+    }
+    if(pos + sizeof(int) * hdr.nverts + sizeof(CheckpointEntry) * hdr.nregions > size) {
+        fprintf(stderr, "Checkpoint file '%s' is truncated.\n", checkpoint.fname);
+        return false;
+    }
+
+    memcpy(checkpoint.tiles, map + pos, sizeof(int) * hdr.nverts);
+    pos += sizeof(int) * hdr.nverts;
+    for(r = 0; r < regions.nregions; r++) {
+        memcpy(&checkpoint.region[r].entry, map + pos, sizeof(CheckpointEntry));
+        pos += sizeof(CheckpointEntry);
+    }
+
+    for(r = 0; r < regions.nregions; r++) {
+        cr = checkpoint.region + r;
+        switch(cr->entry.state) {
+            case CHECKPOINT_NONE:
+                break;
+
+            case CHECKPOINT_SOLVED:
+                for(i = regions.start[r]; i < regions.start[r + 1]; i++) {
+                    t = checkpoint.tiles[regions.vert[i]];
+                    if(t < 0 || t >= compat.ntiles) {
+                        fprintf(stderr, "Checkpoint file '%s' is corrupt.\n", checkpoint.fname);
+                        return false;
+                    }
+                }
+                break;
+
+            case CHECKPOINT_RUNNING:
+                if(cr->entry.len > size - pos) {
+                    fprintf(stderr, "Checkpoint file '%s' is truncated.\n", checkpoint.fname);
+                    return false;
+                }
+                cr->data = malloc(cr->entry.len);
+                if(!cr->data) {
+                    printf("Unable to allocate checkpoint state.\n");
+                    abort();
+                }
+                memcpy(cr->data, map + pos, cr->entry.len);
+                pos += cr->entry.len;
+                break;
+
+            default:
+                fprintf(stderr, "Checkpoint file '%s' is corrupt.\n", checkpoint.fname);
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Copies the state file into checkpoint. Returns boolean success.
+//==============================================================================
+
+static bool checkpoint_load(void) {
+    struct stat st;
+    uint8_t    *map;
+    bool        ok;
+    int         fd;
+
+    fd = open(checkpoint.fname, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Unable to open checkpoint file '%s'.\n", checkpoint.fname);
+        return false;
+    }
+    if(fstat(fd, &st) || st.st_size < (off_t)sizeof(CheckpointHeader)) {
+        fprintf(stderr, "Checkpoint file '%s' is truncated.\n", checkpoint.fname);
+        close(fd);
+        return false;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        fprintf(stderr, "Unable to map checkpoint file '%s'.\n", checkpoint.fname);
+        return false;
+    }
+
+    ok = checkpoint_parse(map, st.st_size);
+    munmap(map, st.st_size);
+
+    return ok;
+}
+
+
+//==============================================================================
+// Syncs the directory that holds fname to disk, which makes a rename into it
+// durable. Returns boolean success.
+//==============================================================================
+
+static bool checkpoint_sync_dir(char *fname) {
+    char *dir, *slash;
+    int   fd;
+    bool  ok;
+
+    dir   = copy_string(fname);
+    slash = strrchr(dir, '/');
+    if(!slash)
+        strcpy(dir, ".");
+    else
+        slash[slash == dir] = '\0';
+
+    fd = open(dir, O_RDONLY);
+    ok = fd >= 0 && !fsync(fd);
+    if(fd >= 0)
+        close(fd);
+    free(dir);
+
+    return ok;
+}
+
+
+//==============================================================================
+// Writes everything captured so far to the state file. The data goes into a
+// new file under a temporary name, through a shared mapping that is synced to
+// disk before the file replaces the previous one, and the directory is synced
+// after that so that the rename survives a crash. The caller must hold
+// checkpoint.lock. Returns boolean success.
+//==============================================================================
+
+static bool checkpoint_flush(void) {
+    CheckpointHeader hdr;
+    uint8_t         *map;
+    char            *tmp;
+    size_t           size, pos;
+    int              fd, r;
+    bool             ok;
+
+    size = sizeof(CheckpointHeader) + sizeof(int) * config.vert.used
+         + sizeof(CheckpointEntry) * regions.nregions;
+    for(r = 0; r < regions.nregions; r++)
+        if(checkpoint.region[r].entry.state == CHECKPOINT_RUNNING)
+            size += checkpoint.region[r].entry.len;
+
+    tmp = malloc(strlen(checkpoint.fname) + 5);
+    if(!tmp) {
+        printf("Unable to allocate checkpoint file name.\n");
+        abort();
+    }
+    sprintf(tmp, "%s.tmp", checkpoint.fname);
+
+    fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        fprintf(stderr, "Unable to create checkpoint file '%s'.\n", tmp);
+        free(tmp);
+        return false;
+    }
+    if(ftruncate(fd, size)
+            || (map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        fprintf(stderr, "Unable to map checkpoint file '%s'.\n", tmp);
+        close(fd);
+        unlink(tmp);
+        free(tmp);
+        return false;
+    }
+    close(fd);
+
+    memset(&hdr, 0, sizeof(CheckpointHeader));
+    memcpy(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic));
+    hdr.fingerprint = checkpoint.fingerprint;
+    hdr.nverts      = config.vert.used;
+    hdr.nregions    = regions.nregions;
+
+    memcpy(map, &hdr, sizeof(CheckpointHeader));
+    pos = sizeof(CheckpointHeader);
+    memcpy(map + pos, checkpoint.tiles, sizeof(int) * config.vert.used);
+    pos += sizeof(int) * config.vert.used;
+    for(r = 0; r < regions.nregions; r++) {
+        memcpy(map + pos, &checkpoint.region[r].entry, sizeof(CheckpointEntry));
+        pos += sizeof(CheckpointEntry);
+    }
+    for(r = 0; r < regions.nregions; r++) {
+        if(checkpoint.region[r].entry.state != CHECKPOINT_RUNNING)
+            continue;
+        memcpy(map + pos, checkpoint.region[r].data, checkpoint.region[r].entry.len);
+        pos += checkpoint.region[r].entry.len;
+    }
+
+    ok = !msync(map, size, MS_SYNC);
+    munmap(map, size);
+    if(ok)
+        ok = !rename(tmp, checkpoint.fname) && checkpoint_sync_dir(checkpoint.fname);
+    if(!ok) {
+        fprintf(stderr, "Unable to write checkpoint file '%s'.\n", checkpoint.fname);
+        unlink(tmp);
+    }
+    free(tmp);
+
+    return ok;
+}
+
+
+//==============================================================================
+// Ends checkpointing. If finished is true, the solve has reached its verdict
+// and the state file is removed.
+//==============================================================================
+
+void checkpoint_close(bool finished) {
+    int r;
+
+    if(!checkpoint.fname)
+        return;
+
+    if(finished)
+        unlink(checkpoint.fname);
+    for(r = 0; r < regions.nregions; r++)
+        free(checkpoint.region[r].data);
+    free(checkpoint.region);
+    free(checkpoint.tiles);
+    pthread_mutex_destroy(&checkpoint.lock);
+    memset(&checkpoint, 0, sizeof(Checkpoint));
+}
+
+
+//==============================================================================
+// Records that region has been solved, with the tiles of its vertices in
+// tiles and the counters of the solve in stats, and writes the file if it is
+// due.
+//==============================================================================
+
+void checkpoint_done(int region, int *tiles, SolverStats *stats) {
+    CheckpointRegion *cr = checkpoint.region + region;
+    double            now;
+    int               i, v;
+
+    if(!checkpoint.fname)
+        return;
+
+    pthread_mutex_lock(&checkpoint.lock);
+    for(i = regions.start[region]; i < regions.start[region + 1]; i++) {
+        v = regions.vert[i];
+        checkpoint.tiles[v] = tiles[v];
+    }
+    free(cr->data);
+    cr->data        = NULL;
+    cr->entry.state = CHECKPOINT_SOLVED;
+    cr->entry.len   = 0;
+    cr->entry.stats = *stats;
+    now = solver_clock();
+    if(now - checkpoint.written >= checkpoint.interval) {
+        checkpoint.written = now;
+        checkpoint_flush();
+    }
+    pthread_mutex_unlock(&checkpoint.lock);
+}
+
+
+//==============================================================================
+// Turns on checkpointing to fname every interval seconds for a solve with the
+// base options opt and portfolios of nworkers solvers. If resume is true, the
+// state saved in fname is loaded first, which must belong to the same config
+// and options. Must be called after compat_build() and region_build(). Returns
+// boolean success.
+//==============================================================================
+
+bool checkpoint_open(char *fname, double interval, bool resume, SolverOptions *opt, int nworkers) {
+    int r, v;
+
+    checkpoint_close(false);
+
+    checkpoint.fname       = fname;
+    checkpoint.interval    = interval;
+    checkpoint.fingerprint = checkpoint_fingerprint(opt, nworkers);
+    checkpoint.tiles       = malloc(sizeof(int) * (config.vert.used + 1));
+    checkpoint.region      = calloc(regions.nregions + 1, sizeof(CheckpointRegion));
+    if(!checkpoint.tiles || !checkpoint.region) {
+        printf("Unable to allocate checkpoint.\n");
+        abort();
+    }
+    pthread_mutex_init(&checkpoint.lock, NULL);
+
+    for(v = 0; v < config.vert.used; v++)
+        checkpoint.tiles[v] = -1;
+
+    if(resume && !checkpoint_load()) {
+        checkpoint_close(false);
+        return false;
+    }
+
+    checkpoint.written = solver_clock();
+    for(r = 0; r < regions.nregions; r++)
+        checkpoint.region[r].saved = checkpoint.written;
+
+    return true;
+}
+
+
+//==============================================================================
+// Captures the state of pf, the portfolio solving region, to be written with
+// the next checkpoint.
+//==============================================================================
+
+void checkpoint_capture(Portfolio *pf, int region) {
+    CheckpointRegion *cr;
+    Transfer          io = { .save = true, .ok = true };
+    uint8_t          *data;
+
+    if(!checkpoint.fname)
+        return;
+
+    cr = checkpoint.region + region;
+    transfer_portfolio(&io, pf);
+    data = malloc(io.pos);
+    if(!data) {
+        printf("Unable to allocate checkpoint state.\n");
+        abort();
+    }
+    io.out = data;
+    io.pos = 0;
+    transfer_portfolio(&io, pf);
+
+    pthread_mutex_lock(&checkpoint.lock);
+    free(cr->data);
+    cr->data        = data;
+    cr->entry.state = CHECKPOINT_RUNNING;
+    cr->entry.len   = io.pos;
+    cr->saved       = solver_clock();
+    pthread_mutex_unlock(&checkpoint.lock);
+}
+
+
+//==============================================================================
+// Called by the portfolio solving region between epochs. Once interval
+// seconds have passed since the region's last capture, its state is captured
+// again, and once they have passed since the file was last written, the file
+// is written.
+//==============================================================================
+
+void checkpoint_poll(Portfolio *pf, int region) {
+    double now;
+
+    if(!checkpoint.fname)
+        return;
+
+    now = solver_clock();
+    if(now - checkpoint.region[region].saved < checkpoint.interval)
+        return;
+    checkpoint_capture(pf, region);
+
+    pthread_mutex_lock(&checkpoint.lock);
+    if(now - checkpoint.written >= checkpoint.interval) {
+        checkpoint.written = now;
+        checkpoint_flush();
+    }
+    pthread_mutex_unlock(&checkpoint.lock);
+}
+
+
+//==============================================================================
+// Puts the workers of pf, which solves region, back into the state captured
+// for it, if there is one. Worker 0 must already be set up. Returns false if
+// the state does not fit, in which case the workers are left in an undefined
+// state.
+//==============================================================================
+
+bool checkpoint_restore(Portfolio *pf, int region) {
+    CheckpointRegion *cr;
+    Transfer          io = { .save = false, .ok = true };
+
+    if(!checkpoint.fname || checkpoint.region[region].entry.state != CHECKPOINT_RUNNING)
+        return true;
+
+    cr     = checkpoint.region + region;
+    io.in  = cr->data;
+    io.len = cr->entry.len;
+    transfer_portfolio(&io, pf);
+
+    if(!io.ok || io.pos != io.len) {
+        fprintf(stderr, "Checkpoint state of region %d does not fit, solving it from the start.\n", region);
+        return false;
+    }
+    return true;
+}
+
+
+//==============================================================================
+// If region was solved before the checkpoint was written, copies the tiles of
+// its vertices to tiles and the counters of its solve to stats and returns
+// true. Returns false otherwise.
+//==============================================================================
+
+bool checkpoint_solved(int region, int *tiles, SolverStats *stats) {
+    int i, v;
+
+    if(!checkpoint.fname || checkpoint.region[region].entry.state != CHECKPOINT_SOLVED)
+        return false;
+
+    for(i = regions.start[region]; i < regions.start[region + 1]; i++) {
+        v = regions.vert[i];
+        tiles[v] = checkpoint.tiles[v];
+    }
+    *stats = checkpoint.region[region].entry.stats;
+    return true;
+}
+
+
+//==============================================================================
+// Writes everything captured so far to the state file. Returns boolean
+// success.
+//==============================================================================
+
+bool checkpoint_write(void) {
+    bool ok;
+
+    if(!checkpoint.fname)
+        return true;
+
+    pthread_mutex_lock(&checkpoint.lock);
+    checkpoint.written = solver_clock();
+    ok = checkpoint_flush();
+    pthread_mutex_unlock(&checkpoint.lock);
+
+    return ok;
+}
+
+
+//==============================================================================
+// Copies n bytes from data to the output of io, or from the input of io to
+// data, and advances the position. A save with no output only counts the
+// bytes. A load that would read past the end of the input fails io instead.
+//==============================================================================
+
+void transfer(Transfer *io, void *data, size_t n) {
+    if(io->save) {
+        if(io->out)
+            memcpy(io->out + io->pos, data, n);
+    } else {
+        if(!io->ok || n > io->len - io->pos) {
+            io->ok = false;
+            return;
+        }
+        memcpy(data, io->in + io->pos, n);
+    }
+    io->pos += n;
+}
+
+
+//==============================================================================
+// Saves or loads the state of every worker in pf. Loading sets up the workers
+// that are not ready yet.
+//==============================================================================
+
+void transfer_portfolio(Transfer *io, Portfolio *pf) {
+    PortfolioWorker *w;
+    bool             ready;
+    int              i, nworkers = pf->nworkers;
+
+    transfer(io, &nworkers, sizeof(int));
+    if(!io->save && nworkers != pf->nworkers)
+        io->ok = false;
+
+    for(i = 0; i < pf->nworkers; i++) {
+        w     = pf->worker + i;
+        ready = w->ready;
+        transfer(io, &ready, sizeof(bool));
+        if(!io->save && !io->ok)
+            return;
+        if(!ready)
+            continue;
+
+        if(!io->save && !w->ready) {
+            w->ready = true;
+            if(!solver_init(&w->sv, &w->opt)) {
+                io->ok = false;
+                return;
+            }
+        }
+        transfer_solver(io, &w->sv);
+    }
+}
+
+
+//==============================================================================
+// Grows *ary, an array of *size elements of elem bytes, to hold at least cnt.
+//==============================================================================
+
+static void reserve(void **ary, int *size, int cnt, size_t elem) {
+    if(cnt <= *size)
+        return;
+    *ary = realloc(*ary, elem * cnt);
+    if(!*ary) {
+        printf("Unable to allocate solver state.\n");
+        abort();
+    }
+    *size = cnt;
+}
+
+
+//==============================================================================
+// Saves or loads everything about sv that changes during the search. Loading
+// requires sv to have been set up by solver_init() with the same options, and
+// everything else is left as solver_init() made it.
+//==============================================================================
+
+void transfer_solver(Transfer *io, Solver *sv) {
+    NogoodCache *nc = &sv->nogoods;
+    AliasTable  *at;
+    BucketQueue *q = &sv->mrv;
+    size_t       n = sv->nverts;
+    bool         alloc;
+    int          v;
+
+    transfer(io, &sv->qhead, sizeof(int));
+    transfer(io, &sv->qcnt, sizeof(int));
+    transfer(io, &sv->cursor, sizeof(int));
+    transfer(io, &sv->trail_len, sizeof(int));
+    transfer(io, &sv->reasons_len, sizeof(int));
+    transfer(io, &sv->level, sizeof(int));
+    transfer(io, &sv->conflict, sizeof(int));
+    transfer(io, &sv->stamp, sizeof(int));
+    transfer(io, &sv->started, sizeof(bool));
+    transfer(io, &sv->result, sizeof(int));
+    transfer(io, &sv->restart_limit, sizeof(uint64_t));
+    transfer(io, &sv->restart_count, sizeof(uint64_t));
+    transfer(io, &sv->bump, sizeof(double));
+    transfer(io, &sv->stats, sizeof(SolverStats));
+    transfer(io, &sv->assigned, sizeof(int));
+    transfer(io, &sv->best, sizeof(int));
+
+    if(!io->save) {
+        if(!io->ok || sv->trail_len < 0 || sv->reasons_len < 0 || sv->level < 0 || sv->level > sv->nverts
+                || sv->qcnt < 0 || sv->qcnt > sv->nverts) {
+            io->ok = false;
+            return;
+        }
+        reserve((void **)&sv->trail, &sv->trail_size, sv->trail_len, sizeof(TrailEntry));
+        reserve((void **)&sv->reasons, &sv->reasons_size, sv->reasons_len, sizeof(int));
+    }
+
+    transfer(io, sv->dom, sizeof(uint64_t) * n * sv->words);
+    transfer(io, sv->size, sizeof(int) * n);
+    transfer(io, sv->weight, sizeof(double) * n);
+    transfer(io, sv->wlogw, sizeof(double) * n);
+    transfer(io, sv->queue, sizeof(int) * n);
+    transfer(io, sv->queued, sizeof(bool) * n);
+    transfer(io, sv->trail, sizeof(TrailEntry) * sv->trail_len);
+    transfer(io, sv->reasons, sizeof(int) * sv->reasons_len);
+    transfer(io, sv->levels, sizeof(Level) * (n + 1));
+    transfer(io, sv->mark, sizeof(int) * n);
+    transfer(io, sv->level_mark, sizeof(int) * (n + 1));
+    transfer(io, sv->attempts, sizeof(uint32_t) * n);
+    transfer(io, sv->best_tile, sizeof(int) * n);
+    transfer(io, sv->score, sizeof(double) * n);
+
+    if(counts.nlimits) {
+        transfer(io, &sv->limits.npending, sizeof(int));
+        if(!io->save && (!io->ok || sv->limits.npending < 0 || sv->limits.npending > counts.nlimits)) {
+            io->ok = false;
+            return;
+        }
+        transfer(io, sv->limits.must, sizeof(int) * counts.nlimits);
+        transfer(io, sv->limits.may, sizeof(int) * counts.nlimits);
+        transfer(io, sv->limits.pending, sizeof(int) * sv->limits.npending);
+        transfer(io, sv->limits.queued, sizeof(bool) * counts.nlimits);
+    }
+
+    if(sv->opt.select == SELECT_MRV) {
+        transfer(io, q->head, sizeof(int) * q->nbuckets);
+        transfer(io, q->next, sizeof(int) * q->nitems);
+        transfer(io, q->prev, sizeof(int) * q->nitems);
+        transfer(io, q->key, sizeof(int) * q->nitems);
+        transfer(io, &q->min, sizeof(int));
+        transfer(io, &q->cnt, sizeof(int));
+    }
+
+    // Alias tables are saved rather than rebuilt, since a rebuilt table could
+    // order its columns differently and so change later random draws.
+
+    for(v = 0; v < sv->nverts; v++) {
+        at = sv->alias + v;
+        transfer(io, &at->n, sizeof(int));
+        transfer(io, &at->weight, sizeof(double));
+        if(!io->save) {
+            if(!io->ok || at->n < 0 || at->n > sv->ntiles) {
+                io->ok = false;
+                return;
+            }
+            if(at->n)
+                alias_reserve(at, at->n, sv->words);
+        }
+        if(!at->n)
+            continue;
+        transfer(io, at->tile, sizeof(int) * at->n);
+        transfer(io, at->alias, sizeof(int) * at->n);
+        transfer(io, at->cut, sizeof(uint32_t) * at->n);
+        transfer(io, at->set, sizeof(uint64_t) * sv->words);
+    }
+
+    alloc = nc->nlits != NULL;
+    transfer(io, &alloc, sizeof(bool));
+    transfer(io, &nc->used, sizeof(int));
+    transfer(io, &nc->head, sizeof(int));
+    transfer(io, &nc->tail, sizeof(int));
+    if(!io->save) {
+        if(!io->ok || (alloc && !nc->capacity)) {
+            io->ok = false;
+            return;
+        }
+        if(alloc && !nc->nlits)
+            nogood_alloc(nc);
+    }
+    if(alloc) {
+        n = nc->capacity;
+        transfer(io, nc->nlits, sizeof(int) * n);
+        transfer(io, nc->vertex, sizeof(int) * n * NOGOOD_MAX_LITS);
+        transfer(io, nc->tile, sizeof(int) * n * NOGOOD_MAX_LITS);
+        transfer(io, nc->hash, sizeof(uint64_t) * n);
+        transfer(io, nc->prev, sizeof(int) * n);
+        transfer(io, nc->next, sizeof(int) * n);
+        transfer(io, nc->lit_head, sizeof(int) * (nc->mask + 1));
+        transfer(io, nc->lit_next, sizeof(int) * n * NOGOOD_MAX_LITS);
+        transfer(io, nc->set_head, sizeof(int) * (nc->mask + 1));
+        transfer(io, nc->set_next, sizeof(int) * n);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "portfolio.h"
+#include "solver.h"
+
+//##############################################################################
+//# Checkpointing of long solves. With --checkpoint, the complete state of every
+//# region is written to a file every few minutes: the tiles of the regions
+//# that are solved, and for each region still in progress a flat copy of every
+//# portfolio worker's solver: domains, trail, reasons, decision levels, random
+//# draw counters, nogood cache and counters. With --resume, a later run with
+//# the same config and options picks the state up again, and since the search
+//# is deterministic it ends up with exactly the solution that the interrupted
+//# run would have found.
+//#
+//# Regions are independent, so each one captures its state on its own between
+//# portfolio epochs, and the file combines whatever each region captured last.
+//# The file is written through a shared memory mapping under a temporary name
+//# and renamed into place once synced, so it is always complete.
+//##############################################################################
+
+#define CHECKPOINT_MAGIC    "TLCKPT01"
+#define CHECKPOINT_INTERVAL 300.0    // default seconds between snapshots
+
+#define CHECKPOINT_NONE    0     // region not captured yet
+#define CHECKPOINT_RUNNING 1     // region captured in the middle of its search
+#define CHECKPOINT_SOLVED  2     // region solved, its tiles are known
+
+typedef struct {             // Start of the state file
+    char     magic[8];           // CHECKPOINT_MAGIC
+    uint64_t fingerprint;        // see checkpoint_open()
+    int32_t  nverts;
+    int32_t  nregions;
+} CheckpointHeader;
+
+typedef struct {             // Per-region entry, after the header and nverts tiles
+    int32_t     state;           // CHECKPOINT_*
+    uint64_t    len;             // CHECKPOINT_RUNNING: bytes of portfolio state, which
+                                 // follow the entries in region order
+    SolverStats stats;           // CHECKPOINT_SOLVED: counters of the finished solve
+} CheckpointEntry;
+
+typedef struct {             // Latest capture of one region
+    CheckpointEntry entry;
+    uint8_t        *data;        // CHECKPOINT_RUNNING: serialized portfolio
+    double          saved;       // monotonic time of the capture
+} CheckpointRegion;
+
+typedef struct {
+    char             *fname;         // state file, NULL if checkpointing is off
+    double            interval;      // seconds between snapshots
+    uint64_t          fingerprint;   // hash of the config and options the state belongs to
+    int              *tiles;         // tiles of the solved regions, -1 elsewhere
+    CheckpointRegion *region;        // regions.nregions captures
+    double            written;       // monotonic time the file was last written
+    pthread_mutex_t   lock;          // guards everything above once the solve runs
+} Checkpoint;
+
+typedef struct {             // Position and direction of a state transfer, see transfer()
+    bool           save;         // true to copy state out, false to copy it back in
+    uint8_t       *out;          // save: destination, or NULL to only measure
+    const uint8_t *in;           // load: source
+    size_t         pos;          // bytes transferred so far
+    size_t         len;          // load: bytes available
+    bool           ok;           // false once a load runs out of bytes or finds a bad count
+} Transfer;
+
+extern Checkpoint checkpoint;
+
+
+// Prototypes ==================================================================
+
+void checkpoint_capture(Portfolio *pf, int region);
+void checkpoint_close(bool finished);
+void checkpoint_done(int region, int *tiles, SolverStats *stats);
+bool checkpoint_open(char *fname, double interval, bool resume, SolverOptions *opt, int nworkers);
+void checkpoint_poll(Portfolio *pf, int region);
+bool checkpoint_restore(Portfolio *pf, int region);
+bool checkpoint_solved(int region, int *tiles, SolverStats *stats);
+bool checkpoint_write(void);
+void transfer(Transfer *io, void *data, size_t n);
+void transfer_portfolio(Transfer *io, Portfolio *pf);
+void transfer_solver(Transfer *io, Solver *sv);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,255 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat.h"
+#include "label.h"
+
+//##############################################################################
+//# Precomputed tile compatibility matrix.
+//##############################################################################
+
+Compat compat;
+
+
+//==============================================================================
+// Builds the compatibility matrix, the tile weights and the sampling table
+// over all tiles from config.tile, and selects the bitset kernels for rows of
+// that size. Must be called after parse_config(). For each direction, the
+// tiles are first grouped by the label of their opposite side, so that a row
+// only has to check the tiles whose label its side accepts rather than every
+// tile. With an odd number of directions, no direction has an opposite, and
+// sides are left unconstrained: every tile may sit there, with or without a
+// neighbor. Returns boolean success.
+//==============================================================================
+
+bool compat_build(void) {
+    Tile     *a, *b;
+    int      *start, *by_label;
+    int       t, u, d, i, k, id, opp;
+
+    compat_free();
+    bitset_init();
+
+    compat.ntiles = config.tile.used;
+    compat.ndirs  = config.dir.used - 1;
+    compat.words  = BITSET_WORDS(compat.ntiles);
+
+    compat.rows = calloc((size_t)compat.ntiles * compat.ndirs * compat.words, sizeof(uint64_t));
+    compat.border = calloc((size_t)compat.ndirs * compat.words, sizeof(uint64_t));
+    compat.live   = calloc(compat.words ? compat.words : 1, sizeof(uint64_t));
+    compat.weight = malloc(sizeof(double) * compat.ntiles);
+    compat.wlogw  = malloc(sizeof(double) * compat.ntiles);
+    start         = malloc(sizeof(int) * (labels.count + 1));
+    by_label      = malloc(sizeof(int) * (compat.ntiles + 1));
+    if(!compat.rows || !compat.border || !compat.live || !compat.weight || !compat.wlogw || !start || !by_label) {
+        printf("Unable to allocate compatibility matrix.\n");
+        abort();
+    }
+
+    for(t = 0; t < compat.ntiles; t++) {
+        compat.weight[t] = ((Tile *)config.tile.ary[t])->weight;
+        compat.wlogw[t]  = compat.weight[t] * log(compat.weight[t]);
+    }
+
+    for(d = 1; d <= compat.ndirs; d++) {
+        opp = get_opposite_dir(d);
+        if(!opp) {
+            bitset_fill(compat_border(d), compat.ntiles);
+            for(t = 0; t < compat.ntiles; t++)
+                bitset_fill(compat_row(t, d), compat.ntiles);
+            continue;
+        }
+
+        // Counting sort of the tiles by the label ID of their side facing
+        // opp: those with ID i end up in by_label from start[i] up to
+        // start[i + 1].
+
+        memset(start, 0, sizeof(int) * (labels.count + 1));
+        for(u = 0; u < compat.ntiles; u++)
+            start[((Tile *)config.tile.ary[u])->side[opp].label_id + 1]++;
+        for(i = 0; i < labels.count; i++)
+            start[i + 1] += start[i];
+        for(u = 0; u < compat.ntiles; u++)
+            by_label[start[((Tile *)config.tile.ary[u])->side[opp].label_id]++] = u;
+        for(i = labels.count; i > 0; i--)
+            start[i] = start[i - 1];
+        start[0] = 0;
+
+        for(t = 0; t < compat.ntiles; t++) {
+            a = config.tile.ary[t];
+
+            if(a->side[d].endcap)
+                bitset_set(compat_border(d), t);
+
+            if(a->side[d].match_any) {
+                for(u = 0; u < compat.ntiles; u++) {
+                    b = config.tile.ary[u];
+                    if(surface_accepts(&b->side[opp], &a->side[d]))
+                        bitset_set(compat_row(t, d), u);
+                }
+                continue;
+            }
+
+            id = a->side[d].accept ? bitset_first(a->side[d].accept, labels.words) : a->side[d].label_id;
+            while(id >= 0) {
+                for(k = start[id]; k < start[id + 1]; k++) {
+                    b = config.tile.ary[by_label[k]];
+                    if(surface_accepts(&b->side[opp], &a->side[d]))
+                        bitset_set(compat_row(t, d), by_label[k]);
+                }
+                id = a->side[d].accept ? bitset_next(a->side[d].accept, labels.words, id + 1) : -1;
+            }
+        }
+    }
+    free(start);
+    free(by_label);
+
+    bitset_fill(compat.live, compat.ntiles);
+    if(compat.ntiles)
+        alias_build(&compat.alias, compat.live, compat.words, compat.weight);
+
+    return true;
+}
+
+
+//==============================================================================
+// Releases the matrix storage.
+//==============================================================================
+
+void compat_free(void) {
+    free(compat.rows);
+    free(compat.border);
+    free(compat.live);
+    free(compat.weight);
+    free(compat.wlogw);
+    compat.rows   = NULL;
+    compat.border = NULL;
+    compat.live   = NULL;
+    compat.weight = NULL;
+    compat.wlogw  = NULL;
+    alias_free(&compat.alias);
+}
+
+
+//==============================================================================
+// Removes the tiles that no solution can use, repeating to a fixpoint: tiles
+// that no vertex lists as eligible, and tiles with a side that is not an
+// endcap, and so must face a neighbor, but that mates none of the tiles left.
+// Each removed tile is reported, cleared from compat.live and from every row,
+// and left out of the sampling table. Returns false if some vertex is left
+// without an eligible tile. Must be called after compat_build() and once
+// config.vert is loaded; with config.band set, every tile counts as eligible.
+//==============================================================================
+
+bool compat_prune(void) {
+    Tile     *tile;
+    uint64_t *row;
+    int      *elig;
+    int       v, t, d, i, n, cnt = 0;
+    bool      any, changed;
+
+    // Tiles missing from every eligible list --------------------------------
+
+    any = config.band || !config.vert.used;
+    if(!any) {
+        memset(compat.live, 0, sizeof(uint64_t) * compat.words);
+        for(v = 0; v < config.vert.used && !any; v++) {
+            elig = vertex_eligible(&config.vert, v, &n);
+            any  = !n;
+            for(i = 0; i < n; i++)
+                bitset_set(compat.live, elig[i]);
+        }
+        if(any)
+            bitset_fill(compat.live, compat.ntiles);
+    }
+    for(t = 0; t < compat.ntiles; t++) {
+        if(!bitset_test(compat.live, t)) {
+            printf("Pruned tile '%s': no vertex lists it as eligible.\n", ((Tile *)config.tile.ary[t])->name);
+            cnt++;
+        }
+    }
+
+    // Tiles with a side that mates nothing left -----------------------------
+
+    do {
+        changed = false;
+        for(t = 0; t < compat.ntiles; t++) {
+            if(!bitset_test(compat.live, t))
+                continue;
+            tile = config.tile.ary[t];
+            for(d = 1; d <= compat.ndirs; d++) {
+                if(tile->side[d].endcap)
+                    continue;
+                row = compat_row(t, d);
+                for(i = 0; i < compat.words && !(row[i] & compat.live[i]); i++)
+                    ;
+                if(i == compat.words)
+                    break;
+            }
+            if(d > compat.ndirs)
+                continue;
+
+            bitset_clear(compat.live, t);
+            printf("Pruned tile '%s': no tile left mates its %s side.\n", tile->name, (char *)config.dir.ary[d]);
+            changed = true;
+            cnt++;
+        }
+    } while(changed);
+
+    if(cnt) {
+        for(t = 0; t < compat.ntiles; t++)
+            for(d = 1; d <= compat.ndirs; d++)
+                bitset_and(compat_row(t, d), compat.live, compat.words);
+        for(d = 1; d <= compat.ndirs; d++)
+            bitset_and(compat_border(d), compat.live, compat.words);
+        alias_free(&compat.alias);
+        if(cnt < compat.ntiles)
+            alias_build(&compat.alias, compat.live, compat.words, compat.weight);
+        printf("Pruned %d of %d tiles.\n", cnt, compat.ntiles);
+    }
+
+    if(cnt == compat.ntiles && (config.band || config.vert.used)) {
+        fprintf(stderr, "No tile is left after pruning.\n");
+        return false;
+    }
+    for(v = 0; v < config.vert.used; v++) {
+        elig = vertex_eligible(&config.vert, v, &n);
+        for(i = 0; i < n && !bitset_test(compat.live, elig[i]); i++)
+            ;
+        if(n && i == n) {
+            fprintf(stderr, "Vertex %d has no eligible tile left after pruning.\n", v);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Returns true if the two facing surfaces may be mated, i.e., each accepts the
+// other.
+//==============================================================================
+
+bool surfaces_match(Surface *a, Surface *b) {
+    return surface_accepts(a, b) && surface_accepts(b, a);
+}
+
+
+//==============================================================================
+// Returns true if surface a accepts surface b as its mate. A matchAny surface
+// accepts everything. Otherwise b's label must appear in a's matchLabels list
+// if there is one, or else equal a's label unless a relies solely on bitmasks.
+// Any nonzero bitmasks are then applied to b's label as well. All of this is
+// folded into a's accept set by label_intern(), which must have been called.
+//==============================================================================
+
+bool surface_accepts(Surface *a, Surface *b) {
+    if(a->match_any)
+        return true;
+    if(a->accept)
+        return bitset_test(a->accept, b->label_id);
+    return a->label_id == b->label_id;
+}
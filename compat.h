@@ -0,0 +1,62 @@
+#ifndef COMPAT_H
+#define COMPAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "alias.h"
+#include "bitset.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Precomputed tile compatibility. After parse_config(), whether each pair of
+//# facing surfaces mates is worked out once and stored as dense bitset rows,
+//# so "which tiles may sit on side d of tile t" is a single row lookup.
+//#
+//# compat_prune() then drops the tiles that no solution can use, clearing them
+//# from every row, so that they never enter a domain.
+//##############################################################################
+
+typedef struct {
+    int       ntiles;        // number of tiles, i.e., bits per row
+    int       ndirs;         // number of directions (config.dir.used - 1)
+    int       words;         // uint64_t words per row
+    uint64_t *rows;          // ntiles * ndirs rows, indexed by tile then direction
+    uint64_t *border;        // ndirs rows of tiles whose side in that direction is an endcap
+    uint64_t *live;          // tiles left by compat_prune(), all of them before it runs
+    double   *weight;        // relative weight of each tile
+    double   *wlogw;         // weight * log(weight) of each tile, for entropy
+    AliasTable alias;        // weighted sampling table over every tile
+} Compat;
+
+extern Compat compat;
+
+
+//==============================================================================
+// Returns the row of tiles that may sit on side dir of tile. dir is an offset
+// into config.dir.ary, i.e., 1-based.
+//==============================================================================
+
+static inline uint64_t *compat_row(int tile, int dir) {
+    return compat.rows + ((size_t)tile * compat.ndirs + (dir - 1)) * compat.words;
+}
+
+
+//==============================================================================
+// Returns the row of tiles that may have no neighbor on side dir.
+//==============================================================================
+
+static inline uint64_t *compat_border(int dir) {
+    return compat.border + (size_t)(dir - 1) * compat.words;
+}
+
+
+// Prototypes ==================================================================
+
+bool compat_build(void);
+void compat_free(void);
+bool compat_prune(void);
+bool surface_accepts(Surface *a, Surface *b);
+bool surfaces_match(Surface *a, Surface *b);
+
+#endif // COMPAT_H
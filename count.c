@@ -0,0 +1,157 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat.h"
+#include "count.h"
+
+//##############################################################################
+//# Global tile-count limits.
+//##############################################################################
+
+Counts counts;
+
+
+//==============================================================================
+// Builds a group for every master tile with a minCount or maxCount, turning
+// percentages into vertex counts: a minimum is rounded up and a maximum down.
+// Must be called after compat_build() and once config.vert is loaded. Returns
+// false if a tile's limits leave no count that satisfies both.
+//==============================================================================
+
+bool count_build(void) {
+    CountLimit *cl;
+    Tile       *tile;
+    double      min, max;
+    int         t, i;
+
+    count_free();
+
+    counts.group = malloc(sizeof(int) * (compat.ntiles + 1));
+    counts.limit = malloc(sizeof(CountLimit) * (compat.ntiles + 1));
+    if(!counts.group || !counts.limit) {
+        printf("Unable to allocate tile count limits.\n");
+        abort();
+    }
+
+    for(t = 0; t < compat.ntiles; t++) {
+        tile = config.tile.ary[t];
+        counts.group[t] = t == tile->master ? -1 : counts.group[tile->master];
+        if(t != tile->master || (tile->min_count < 0 && tile->max_count < 0))
+            continue;
+
+        min = tile->min_count < 0 ? 0 : tile->min_count;
+        max = tile->max_count < 0 ? config.vert.used : tile->max_count;
+        if(tile->min_percent)
+            min = ceil(min * config.vert.used / 100.0);
+        if(tile->max_percent)
+            max = floor(max * config.vert.used / 100.0);
+        if(min > max) {
+            fprintf(stderr, "Tile '%s' has a minCount above its maxCount for %d vertices.\n",
+                tile->name, config.vert.used);
+            return false;
+        }
+
+        cl = counts.limit + counts.nlimits;
+        cl->first = t;
+        cl->last  = t + tile->variants;
+        cl->min   = min;
+        cl->max   = max < config.vert.used ? max : config.vert.used;
+        cl->set   = calloc(compat.words, sizeof(uint64_t));
+        if(!cl->set) {
+            printf("Unable to allocate tile count limits.\n");
+            abort();
+        }
+        for(i = cl->first; i < cl->last; i++)
+            bitset_set(cl->set, i);
+        counts.group[t] = counts.nlimits++;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Releases the limits.
+//==============================================================================
+
+void count_free(void) {
+    int g;
+
+    for(g = 0; g < counts.nlimits; g++)
+        free(counts.limit[g].set);
+    free(counts.limit);
+    free(counts.group);
+    memset(&counts, 0, sizeof(Counts));
+}
+
+
+//==============================================================================
+// Releases the counters of a solver.
+//==============================================================================
+
+void count_state_free(CountState *cs) {
+    free(cs->must);
+    free(cs->may);
+    free(cs->pending);
+    free(cs->queued);
+    free(cs->seen);
+    free(cs->old);
+    memset(cs, 0, sizeof(CountState));
+}
+
+
+//==============================================================================
+// Allocates zeroed counters for every group, or nothing if there are none.
+//==============================================================================
+
+void count_state_init(CountState *cs) {
+    memset(cs, 0, sizeof(CountState));
+    if(!counts.nlimits)
+        return;
+
+    cs->must    = calloc(counts.nlimits, sizeof(int));
+    cs->may     = calloc(counts.nlimits, sizeof(int));
+    cs->pending = malloc(sizeof(int) * counts.nlimits);
+    cs->queued  = calloc(counts.nlimits, sizeof(bool));
+    cs->seen    = calloc(counts.nlimits, sizeof(int));
+    cs->old     = malloc(sizeof(uint64_t) * compat.words);
+    if(!cs->must || !cs->may || !cs->pending || !cs->queued || !cs->seen || !cs->old) {
+        printf("Unable to allocate tile counters.\n");
+        abort();
+    }
+}
+
+
+//==============================================================================
+// Counts the vertices that hold a tile of each group in tiles, where -1 marks
+// a vertex without one, into held, which may be NULL. Returns the number of
+// groups outside their limits.
+//==============================================================================
+
+int count_tally(int *tiles, int *held) {
+    int *cnt;
+    int  v, g, bad = 0;
+
+    if(!counts.nlimits)
+        return 0;
+
+    cnt = held ? held : malloc(sizeof(int) * counts.nlimits);
+    if(!cnt) {
+        printf("Unable to allocate tile counters.\n");
+        abort();
+    }
+
+    memset(cnt, 0, sizeof(int) * counts.nlimits);
+    for(v = 0; v < config.vert.used; v++)
+        if(tiles[v] >= 0 && tiles[v] < compat.ntiles && (g = counts.group[tiles[v]]) >= 0)
+            cnt[g]++;
+    for(g = 0; g < counts.nlimits; g++)
+        if(cnt[g] < counts.limit[g].min || cnt[g] > counts.limit[g].max)
+            bad++;
+
+    if(!held)
+        free(cnt);
+    return bad;
+}
@@ -0,0 +1,91 @@
+#ifndef COUNT_H
+#define COUNT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bitset.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Global tile-count limits. A tile may set minCount and maxCount, either as a
+//# number of vertices or as a percentage of all vertices, and the limits apply
+//# to the tile in all its orientations together. Each limited tile forms a
+//# group, the contiguous run of tiles from its master on.
+//#
+//# The solver enforces the limits during propagation. For every group it keeps
+//# two counters that follow each domain change and are restored on undo: the
+//# vertices that must take a tile of the group, i.e., whose domain lies within
+//# it, and those that may, i.e., whose domain meets it. Once the first counter
+//# reaches the maximum, the group is removed from every other domain; once the
+//# second falls to the minimum, every vertex that may take the group must.
+//# Going past either limit is a conflict. See solver_limit().
+//#
+//# Limits span the whole lattice, so with any limit set, region_build() puts
+//# all free vertices into a single region.
+//##############################################################################
+
+#define COUNT_UNSET -1.0     // Tile.min_count and max_count: no limit
+
+typedef struct {             // Limit on the vertices holding one group of tiles
+    int       first;             // first tile of the group, its master
+    int       last;              // one past the last tile
+    int       min;               // fewest vertices that must hold a tile of the group
+    int       max;               // most vertices that may
+    uint64_t *set;               // bitset of the group's tiles
+} CountLimit;
+
+typedef struct {
+    int         nlimits;
+    CountLimit *limit;
+    int        *group;           // limit of each tile, -1 if it has none
+} Counts;
+
+typedef struct {             // Per-solver group counters
+    int      *must;              // vertices whose domain lies within each group
+    int      *may;               // vertices whose domain meets each group
+    int      *pending;           // groups that reached a limit and await solver_limit()
+    int       npending;
+    bool     *queued;            // true while the group is in pending
+    int      *seen;              // per-group stamps for solver_recount()
+    int       stamp;
+    uint64_t *old;               // scratch copy of a domain before a change
+} CountState;
+
+extern Counts counts;
+
+
+//==============================================================================
+// Returns true if domain dom holds a tile of group g.
+//==============================================================================
+
+static inline bool count_meets(const uint64_t *dom, int g) {
+    CountLimit *cl = counts.limit + g;
+    int         i;
+
+    for(i = cl->first >> 6; i <= (cl->last - 1) >> 6; i++)
+        if(dom[i] & cl->set[i])
+            return true;
+    return false;
+}
+
+
+//==============================================================================
+// Returns true if domain dom of words words holds tiles of group g and no
+// others.
+//==============================================================================
+
+static inline bool count_within(const uint64_t *dom, int g, int words) {
+    return count_meets(dom, g) && bitset_subset(dom, counts.limit[g].set, words);
+}
+
+
+// Prototypes ==================================================================
+
+bool count_build(void);
+void count_free(void);
+void count_state_free(CountState *cs);
+void count_state_init(CountState *cs);
+int  count_tally(int *tiles, int *held);
+
+#endif // COUNT_H
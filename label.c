@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bitset.h"
+#include "label.h"
+
+//##############################################################################
+//# Interning of surface labels into dense IDs.
+//##############################################################################
+
+Labels labels;
+
+
+//==============================================================================
+// qsort comparator for uint32_t.
+//==============================================================================
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+
+//==============================================================================
+// Returns the ID of label value, or -1 if no surface carries it.
+//==============================================================================
+
+int label_find(uint32_t value) {
+    int lo = 0, hi = labels.count - 1, mid;
+
+    while(lo <= hi) {
+        mid = (lo + hi) / 2;
+        if(labels.value[mid] == value)
+            return mid;
+        if(labels.value[mid] < value)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+
+//==============================================================================
+// Releases the label table. Surface acceptance sets are owned by their tiles.
+//==============================================================================
+
+void label_free(void) {
+    free(labels.value);
+    labels.value = NULL;
+    labels.count = 0;
+    labels.words = 0;
+}
+
+
+//==============================================================================
+// Assigns IDs to the labels of every side in config.tile, and to those listed
+// in matchLabels, and fills in each side's label_id and accept set; see
+// surface_accepts() for the rules the set encodes. Must be called once all
+// tiles, including orientations, are parsed.
+//==============================================================================
+
+void label_intern(void) {
+    Surface  *s;
+    uint32_t *p, v;
+    size_t    size;
+    int       ndirs = config.dir.used - 1, ntiles = config.tile.used;
+    int       t, d, i, n = 0;
+
+    label_free();
+
+    size = (size_t)ntiles * ndirs + 1;
+    for(t = 0; t < ntiles; t++)
+        for(d = 1; d <= ndirs; d++)
+            for(p = ((Tile *)config.tile.ary[t])->side[d].labels; p && *p; p++)
+                size++;
+
+    labels.value = malloc(sizeof(uint32_t) * size);
+    if(!labels.value) {
+        printf("Unable to allocate label table.\n");
+        abort();
+    }
+    for(t = 0; t < ntiles; t++) {
+        for(d = 1; d <= ndirs; d++) {
+            s = &((Tile *)config.tile.ary[t])->side[d];
+            labels.value[n++] = s->label;
+            for(p = s->labels; p && *p; p++)
+                labels.value[n++] = *p;
+        }
+    }
+
+    qsort(labels.value, n, sizeof(uint32_t), compare_u32);
+    for(i = 0; i < n; i++)
+        if(!labels.count || labels.value[labels.count - 1] != labels.value[i])
+            labels.value[labels.count++] = labels.value[i];
+    labels.words = BITSET_WORDS(labels.count);
+
+    for(t = 0; t < ntiles; t++) {
+        for(d = 1; d <= ndirs; d++) {
+            s = &((Tile *)config.tile.ary[t])->side[d];
+            s->label_id = label_find(s->label);
+            s->accept   = NULL;
+            if(s->match_any || (!s->match_labels && !s->any_of && !s->all_of && !s->none_of))
+                continue;
+
+            s->accept = calloc(labels.words, sizeof(uint64_t));
+            if(!s->accept) {
+                printf("Unable to allocate label set.\n");
+                abort();
+            }
+
+            if(s->match_labels) {
+                for(p = s->labels; *p; p++)
+                    bitset_set(s->accept, label_find(*p));
+            } else {
+                bitset_fill(s->accept, labels.count);
+            }
+
+            for(i = bitset_first(s->accept, labels.words); i >= 0; i = bitset_next(s->accept, labels.words, i + 1)) {
+                v = labels.value[i];
+                if((s->any_of && !(v & s->any_of))
+                        || (s->all_of && (v & s->all_of) != s->all_of)
+                        || (s->none_of && (v & s->none_of)))
+                    bitset_clear(s->accept, i);
+            }
+        }
+    }
+}
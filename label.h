@@ -0,0 +1,34 @@
+#ifndef LABEL_H
+#define LABEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tilist.h"
+
+//##############################################################################
+//# Label interning. Once the tiles are parsed, every label carried by some
+//# surface gets a dense ID, in ascending order of label. A surface with a
+//# matchLabels list or bitmasks then has the set of labels it accepts stored
+//# as a bitset over those IDs, so whether it accepts a mate is a single bit
+//# test. Labels that only appear in matchLabels lists get an ID as well, so
+//# that every label a config mentions has one, even though no surface can
+//# offer them as a mate.
+//##############################################################################
+
+typedef struct {
+    int       count;         // number of distinct labels
+    int       words;         // uint64_t words per bitset over label IDs
+    uint32_t *value;         // the labels, indexed by ID
+} Labels;
+
+extern Labels labels;
+
+
+// Prototypes ==================================================================
+
+int  label_find(uint32_t value);
+void label_free(void);
+void label_intern(void);
+
+#endif // LABEL_H
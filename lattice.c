@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lattice.h"
+#include "workpool.h"
+
+//##############################################################################
+//# Procedural lattice generation.
+//##############################################################################
+
+Lattice lattice = { .type = -1 };
+
+
+//==============================================================================
+// Loads rows first..first+nrows-1 of the lattice into config.vert, replacing
+// whatever was there, on config.threads threads. Returns boolean success.
+//==============================================================================
+
+bool lattice_generate(int first, int nrows) {
+    size_t n = (size_t)lattice.width * nrows;
+
+    if(n > LATTICE_MAX_VERTS) {
+        fprintf(stderr, "At most %d lattice vertices can be loaded at once.\n", LATTICE_MAX_VERTS);
+        return false;
+    }
+
+    if(nrows > lattice.rows_alloc) {
+        free(lattice.name);
+        lattice.rows_alloc = nrows;
+        lattice.name       = malloc(n * LATTICE_NAME_LEN);
+        if(!lattice.name) {
+            printf("Unable to allocate lattice.\n");
+            abort();
+        }
+    }
+    vertices_alloc(&config.vert, n, lattice.ndirs);
+
+    lattice.first = first;
+    lattice.nrows = nrows;
+    workpool_run(config.threads, nrows, lattice_row, NULL);
+
+    return true;
+}
+
+
+//==============================================================================
+// Returns the config.vert index of vertex (col, row), -1 if it lies outside
+// the lattice, or NEIGHBOR_OPEN if it lies in a row that is not loaded.
+//==============================================================================
+
+int lattice_index(int col, int row) {
+    if(col < 0 || col >= lattice.width || row < 0 || row >= lattice.height)
+        return -1;
+    if(row < lattice.first || row >= lattice.first + lattice.nrows)
+        return NEIGHBOR_OPEN;
+    return (row - lattice.first) * lattice.width + col;
+}
+
+
+//==============================================================================
+// Computes the pixel position of vertex (col, row).
+//==============================================================================
+
+void lattice_position(int col, int row, int *x, int *y) {
+    switch(lattice.type) {
+        case LATTICE_HEX:
+            *x = col * lattice.spacing_x;
+            *y = row * lattice.spacing_y + (col & 1) * lattice.spacing_y / 2;
+            break;
+        case LATTICE_TRIANGULAR:
+            *x = col * lattice.spacing_x / 2;
+            *y = row * lattice.spacing_y;
+            break;
+        case LATTICE_BRICK:
+            *x = col * lattice.spacing_x + (row & 1) * lattice.spacing_x / 2;
+            *y = row * lattice.spacing_y;
+            break;
+        default:
+            *x = col * lattice.spacing_x;
+            *y = row * lattice.spacing_y;
+            break;
+    }
+
+    *x += lattice.origin_x;
+    *y += lattice.origin_y;
+}
+
+
+//==============================================================================
+// Worker pool job: fills in the config.vert entries of loaded row job. Every
+// neighbor link is derived from the cell's own coordinates, and the rules for
+// each lattice are symmetric, so rows can be generated independently.
+//==============================================================================
+
+void lattice_row(int job, void *ctx) {
+    int32_t *nbr;
+    int      c, r = lattice.first + job, i, odd, up;
+
+    (void)ctx;
+
+    for(c = 0; c < lattice.width; c++) {
+        i   = job * lattice.width + c;
+        nbr = vertex_neighbors(&config.vert, i);
+
+        snprintf(lattice.name + (size_t)i * LATTICE_NAME_LEN, LATTICE_NAME_LEN, "%d,%d", c, r);
+        config.vert.name[i]        = lattice.name + (size_t)i * LATTICE_NAME_LEN;
+        config.vert.order[i]       = i;
+        config.vert.tile[i]        = -1;
+        config.vert.orientation[i] = 0;
+        lattice_position(c, r, &config.vert.x[i], &config.vert.y[i]);
+
+        switch(lattice.type) {
+            case LATTICE_SQUARE:
+                nbr[0] = lattice_index(c, r - 1);
+                nbr[1] = lattice_index(c + 1, r);
+                nbr[2] = lattice_index(c, r + 1);
+                nbr[3] = lattice_index(c - 1, r);
+                break;
+
+            case LATTICE_HEX:
+                odd = c & 1;
+                nbr[0] = lattice_index(c, r - 1);
+                nbr[1] = lattice_index(c + 1, r - 1 + odd);
+                nbr[2] = lattice_index(c + 1, r + odd);
+                nbr[3] = lattice_index(c, r + 1);
+                nbr[4] = lattice_index(c - 1, r + odd);
+                nbr[5] = lattice_index(c - 1, r - 1 + odd);
+                break;
+
+            case LATTICE_TRIANGULAR:
+                up = !((c + r) & 1);
+                nbr[0] = up ? -1 : lattice_index(c, r - 1);
+                nbr[1] = up ? lattice_index(c + 1, r) : -1;
+                nbr[2] = up ? -1 : lattice_index(c + 1, r);
+                nbr[3] = up ? lattice_index(c, r + 1) : -1;
+                nbr[4] = up ? -1 : lattice_index(c - 1, r);
+                nbr[5] = up ? lattice_index(c - 1, r) : -1;
+                break;
+
+            case LATTICE_BRICK:
+                odd = r & 1;
+                nbr[0] = lattice_index(c + odd, r - 1);
+                nbr[1] = lattice_index(c + 1, r);
+                nbr[2] = lattice_index(c + odd, r + 1);
+                nbr[3] = lattice_index(c - 1 + odd, r + 1);
+                nbr[4] = lattice_index(c - 1, r);
+                nbr[5] = lattice_index(c - 1 + odd, r - 1);
+                break;
+        }
+    }
+}
+
+
+//==============================================================================
+// Parses the lattice entry of the config file into lattice and, unless
+// config.band is set, loads all of its vertices into config.vert. The
+// directions must already have been parsed. Returns boolean success.
+//==============================================================================
+
+bool parse_lattice(cJSON *item) {
+    static char       *types[] = { "square", "hex", "triangular", "brick", NULL };
+    static const int   ndirs[] = { 4, 6, 6, 6 };
+    cJSON  *sub;
+    int     i, spacing;
+
+    if(!cJSON_IsObject(item)) {
+        fprintf(stderr, "The lattice element in the config file must be an object.\n");
+        return false;
+    }
+
+    // lattice.type ------------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "type");
+    if(sub == NULL || !cJSON_IsString(sub)) {
+        fprintf(stderr, "The lattice must have a type.\n");
+        return false;
+    }
+    for(i = 0; types[i] && !streq(types[i], sub->valuestring); i++)
+        ;
+    if(!types[i]) {
+        fprintf(stderr, "Unknown lattice type '%s', must be square, hex, triangular or brick.\n", sub->valuestring);
+        return false;
+    }
+    lattice.type  = i;
+    lattice.ndirs = config.dir.used - 1;
+    if(lattice.ndirs != ndirs[i]) {
+        fprintf(stderr, "A %s lattice requires %d directions, but the config file has %d.\n",
+            types[i], ndirs[i], lattice.ndirs);
+        return false;
+    }
+
+    // lattice.width, lattice.height -------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "width");
+    if(sub == NULL || !cJSON_IsNumber(sub) || sub->valueint < 1) {
+        fprintf(stderr, "The lattice must have a positive integer width.\n");
+        return false;
+    }
+    lattice.width = sub->valueint;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "height");
+    if(sub == NULL || !cJSON_IsNumber(sub) || sub->valueint < 1) {
+        fprintf(stderr, "The lattice must have a positive integer height.\n");
+        return false;
+    }
+    lattice.height = sub->valueint;
+
+    // lattice.spacing, or lattice.spacingX and lattice.spacingY ---------------
+
+    spacing = 0;
+    sub = cJSON_GetObjectItemCaseSensitive(item, "spacing");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub) || sub->valueint < 1) {
+            fprintf(stderr, "Malformed lattice spacing, must be a positive integer.\n");
+            return false;
+        }
+        spacing = sub->valueint;
+    }
+    lattice.spacing_x = spacing;
+    lattice.spacing_y = spacing;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "spacingX");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub) || sub->valueint < 1) {
+            fprintf(stderr, "Malformed lattice spacingX, must be a positive integer.\n");
+            return false;
+        }
+        lattice.spacing_x = sub->valueint;
+    }
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "spacingY");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub) || sub->valueint < 1) {
+            fprintf(stderr, "Malformed lattice spacingY, must be a positive integer.\n");
+            return false;
+        }
+        lattice.spacing_y = sub->valueint;
+    }
+
+    if(!lattice.spacing_x || !lattice.spacing_y) {
+        fprintf(stderr, "The lattice must have a spacing, or both spacingX and spacingY.\n");
+        return false;
+    }
+
+    // lattice.originX, lattice.originY (default 0) ----------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "originX");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub)) {
+            fprintf(stderr, "Malformed lattice originX, must be an integer.\n");
+            return false;
+        }
+        lattice.origin_x = sub->valueint;
+    }
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "originY");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub)) {
+            fprintf(stderr, "Malformed lattice originY, must be an integer.\n");
+            return false;
+        }
+        lattice.origin_y = sub->valueint;
+    }
+
+    // Load the whole lattice unless it is to be solved in bands ---------------
+
+    if(config.band)
+        return true;
+
+    return lattice_generate(0, lattice.height);
+}
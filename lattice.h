@@ -0,0 +1,66 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <stdbool.h>
+
+#include "tilist.h"
+
+//##############################################################################
+//# Procedural lattices. Instead of listing every vertex, a config may give a
+//# "lattice" entry, and the vertices, their neighbors and their positions are
+//# generated in memory, one row per worker pool job. The config's directions
+//# are taken in order, clockwise, as follows:
+//#
+//#     square      4 directions: N, E, S, W
+//#     hex         6 directions: N, NE, SE, S, SW, NW
+//#                 flat-topped hexagons in columns, odd columns shifted down
+//#                 by half a row
+//#     triangular  6 directions: N, NE, SE, S, SW, NW
+//#                 triangles alternating point up and point down along each
+//#                 row, half a column apart; an up triangle only has
+//#                 neighbors to its NE, S and NW, a down triangle only to its
+//#                 N, SE and SW, so tiles need endcaps on the other three sides
+//#     brick       6 directions: NE, E, SE, SW, W, NW
+//#                 running bond, odd rows shifted right by half a column
+//#
+//# Vertex (col, row) is named "col,row". Normally the whole lattice is loaded
+//# into config.vert at once, but lattice_generate() can also load any range of
+//# rows, in which case links to rows outside the range are NEIGHBOR_OPEN.
+//# Every vertex only has neighbors in its own row and the rows above and below.
+//##############################################################################
+
+#define LATTICE_SQUARE     0
+#define LATTICE_HEX        1
+#define LATTICE_TRIANGULAR 2
+#define LATTICE_BRICK      3
+
+#define LATTICE_MAX_VERTS  (1 << 28)   // upper bound on the vertices loaded at once
+#define LATTICE_NAME_LEN   24          // room for "col,row" and the terminator
+
+typedef struct {
+    int     type;            // LATTICE_*, or -1 if the config has no lattice
+    int     width;           // columns
+    int     height;          // rows
+    int     spacing_x;       // horizontal distance between columns in pixels
+    int     spacing_y;       // vertical distance between rows in pixels
+    int     origin_x;        // position of vertex (0, 0) in pixels
+    int     origin_y;
+    int     ndirs;           // number of directions
+    int     first;           // first row loaded into config.vert
+    int     nrows;           // number of rows loaded
+    int     rows_alloc;      // rows the name storage has room for
+    char   *name;            // LATTICE_NAME_LEN bytes per loaded vertex
+} Lattice;
+
+extern Lattice lattice;
+
+
+// Prototypes ==================================================================
+
+bool lattice_generate(int first, int nrows);
+int  lattice_index(int col, int row);
+void lattice_position(int col, int row, int *x, int *y);
+void lattice_row(int job, void *ctx);
+bool parse_lattice(cJSON *item);
+
+#endif // LATTICE_H
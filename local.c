@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat.h"
+#include "local.h"
+#include "workpool.h"
+
+//##############################################################################
+//# Min-conflicts local search with tabu.
+//##############################################################################
+
+
+//==============================================================================
+// Returns the number of edges of vertex v that tile t would mismatch given the
+// current tiles of its neighbors, or -1 if t lacks an endcap facing a missing
+// neighbor. A side facing a NEIGHBOR_OPEN vertex is unconstrained.
+//==============================================================================
+
+static int local_cost(LocalSearch *ls, int32_t *nbr, int t) {
+    int d, u, cnt = 0;
+
+    for(d = 1; d <= compat.ndirs; d++) {
+        u = nbr[d - 1];
+        if(u == -1) {
+            if(!bitset_test(compat_border(d), t))
+                return -1;
+        } else if(u >= 0 && !bitset_test(compat_row(t, d), ls->tiles[u])) {
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+
+//==============================================================================
+// Returns a neighbor of vertex v whose edge with v is mismatched although
+// neither of them can move, or -1 if there is none.
+//==============================================================================
+
+static int local_stuck(LocalSearch *ls, int v) {
+    int32_t *nbr;
+    int      d, u;
+
+    if(!ls->conf[v] || (ls->flags[v] & LOCAL_MOVABLE))
+        return -1;
+
+    nbr = vertex_neighbors(&config.vert, v);
+    for(d = 1; d <= compat.ndirs; d++) {
+        u = nbr[d - 1];
+        if(u >= 0 && !(ls->flags[u] & LOCAL_MOVABLE) && !bitset_test(compat_row(ls->tiles[v], d), ls->tiles[u]))
+            return u;
+    }
+
+    return -1;
+}
+
+
+//==============================================================================
+// Returns the next random number of partition lp.
+//==============================================================================
+
+static uint64_t local_draw(LocalPart *lp) {
+    return rng_u64(lp->seed, 0, lp->draws++);
+}
+
+
+//==============================================================================
+// Worker pool job: gives every vertex of partition job a random tile among
+// those that fit its borders, drawn by tile weight, or -1 if there is none,
+// and flags the vertices that have a choice and those with a neighbor in
+// another partition. Draws come from the vertex's own stream.
+//==============================================================================
+
+void local_start(int job, void *ctx) {
+    LocalSearch *ls = ctx;
+    LocalPart   *lp = ls->part + job;
+    int32_t     *nbr;
+    int         *elig;
+    double       sum, w;
+    int          v, d, i, t, n, cnt;
+
+    for(v = lp->first; v < lp->last; v++) {
+        nbr  = vertex_neighbors(&config.vert, v);
+        elig = vertex_eligible(&config.vert, v, &n);
+
+        ls->tiles[v] = -1;
+        ls->flags[v] = 0;
+        ls->slot[v]  = -1;
+        ls->tabu_tile[v] = -1;
+
+        sum = 0;
+        cnt = 0;
+        for(i = 0; i < (n ? n : compat.ntiles); i++) {
+            t = n ? elig[i] : i;
+            if(!bitset_test(compat.live, t))
+                continue;
+            for(d = 1; d <= compat.ndirs; d++)
+                if(nbr[d - 1] == -1 && !bitset_test(compat_border(d), t))
+                    break;
+            if(d <= compat.ndirs)
+                continue;
+
+            w    = compat.weight[t];
+            sum += w;
+            if(rng_double(ls->opt.seed, v, cnt++) * sum < w)
+                ls->tiles[v] = t;
+        }
+
+        if(ls->tiles[v] < 0)
+            continue;
+        if(cnt > 1)
+            ls->flags[v] |= LOCAL_MOVABLE;
+        for(d = 1; d <= compat.ndirs; d++)
+            if(nbr[d - 1] >= 0 && (nbr[d - 1] < lp->first || nbr[d - 1] >= lp->last))
+                ls->flags[v] |= LOCAL_OUTER;
+    }
+}
+
+
+//==============================================================================
+// Worker pool job: counts the mismatched edges of every vertex of partition
+// job and lists the movable ones that have any.
+//==============================================================================
+
+void local_count(int job, void *ctx) {
+    LocalSearch *ls = ctx;
+    LocalPart   *lp = ls->part + job;
+    int          v;
+
+    for(v = lp->first; v < lp->last; v++) {
+        ls->conf[v] = local_cost(ls, vertex_neighbors(&config.vert, v), ls->tiles[v]);
+        local_update(ls, v);
+    }
+}
+
+
+//==============================================================================
+// Adds vertex v to the inner or outer list of its partition if it is movable
+// and has a mismatched edge, and removes it if it is listed but has none.
+//==============================================================================
+
+void local_update(LocalSearch *ls, int v) {
+    LocalPart *lp = ls->part + v / LOCAL_PART_VERTS;
+    int       *list, *cnt;
+
+    if(!(ls->flags[v] & LOCAL_MOVABLE) || (ls->conf[v] > 0) == (ls->slot[v] >= 0))
+        return;
+
+    if(ls->flags[v] & LOCAL_OUTER) {
+        list = lp->outer;
+        cnt  = &lp->nouter;
+    } else {
+        list = lp->inner;
+        cnt  = &lp->ninner;
+    }
+
+    if(ls->conf[v]) {
+        ls->slot[v] = *cnt;
+        list[(*cnt)++] = v;
+    } else {
+        list[ls->slot[v]] = list[--*cnt];
+        ls->slot[list[ls->slot[v]]] = ls->slot[v];
+        ls->slot[v] = -1;
+    }
+}
+
+
+//==============================================================================
+// Moves vertex v of partition lp to the tile that mismatches the fewest of its
+// edges, other than its current one and, unless it mismatches none, the tile
+// it left within the last LOCAL_TABU moves; that tile is taken only if there
+// is no other. Ties are broken at random. The move is made even if it
+// mismatches more edges than the current tile, which lets the search walk off
+// a local minimum.
+//==============================================================================
+
+void local_move(LocalSearch *ls, LocalPart *lp, int v) {
+    int32_t *nbr  = vertex_neighbors(&config.vert, v);
+    int     *elig;
+    int      i, d, u, t, n, c, cur = ls->tiles[v], best = -1, best_c = 0, ties = 0, held = -1, held_c = 0;
+    bool     tabu;
+
+    elig = vertex_eligible(&config.vert, v, &n);
+    tabu = ls->tabu_tile[v] >= 0 && (int32_t)(ls->tabu_until[v] - lp->clock) > 0;
+
+    for(i = 0; i < (n ? n : compat.ntiles); i++) {
+        t = n ? elig[i] : i;
+        if(t == cur || !bitset_test(compat.live, t))
+            continue;
+        c = local_cost(ls, nbr, t);
+        if(c < 0)
+            continue;
+        if(c && tabu && t == ls->tabu_tile[v]) {
+            held   = t;
+            held_c = c;
+            continue;
+        }
+
+        if(best < 0 || c < best_c) {
+            best   = t;
+            best_c = c;
+            ties   = 1;
+        } else if(c == best_c && !(local_draw(lp) % ++ties)) {
+            best = t;
+        }
+    }
+    if(best < 0) {
+        best   = held;
+        best_c = held_c;
+    }
+    if(best < 0) {
+        lp->clock++;
+        lp->moves++;
+        return;
+    }
+
+    // Only edges whose verdict changes affect the counts at either end.
+
+    for(d = 1; d <= compat.ndirs; d++) {
+        u = nbr[d - 1];
+        if(u < 0)
+            continue;
+        c = !bitset_test(compat_row(best, d), ls->tiles[u]) - !bitset_test(compat_row(cur, d), ls->tiles[u]);
+        if(!c)
+            continue;
+        ls->conf[u] += c;
+        local_update(ls, u);
+    }
+
+    ls->tiles[v] = best;
+    ls->conf[v]  = best_c;
+    local_update(ls, v);
+
+    ls->tabu_tile[v]  = cur;
+    ls->tabu_until[v] = lp->clock + LOCAL_TABU;
+    lp->clock++;
+    lp->moves++;
+}
+
+
+//==============================================================================
+// Worker pool job: repairs random inner vertices of partition job until none
+// is left or ls->round moves have been made.
+//==============================================================================
+
+void local_inner(int job, void *ctx) {
+    LocalSearch *ls = ctx;
+    LocalPart   *lp = ls->part + job;
+    int          i;
+
+    for(i = 0; i < ls->round && lp->ninner; i++)
+        local_move(ls, lp, lp->inner[local_draw(lp) % lp->ninner]);
+}
+
+
+//==============================================================================
+// Repairs the mismatches of the assignment that local_start() and
+// local_count() set up in ls, in rounds, until none is left or the move
+// allowance or the deadline runs out. Returns SOLVE_OK if every edge matches,
+// and otherwise SOLVE_BUDGET, after setting the tile of every vertex that
+// still has a mismatched edge to -1. moves receives the number of moves made.
+//==============================================================================
+
+int local_search(LocalSearch *ls, int nthreads, uint64_t *moves) {
+    LocalPart *lp;
+    uint64_t   limit;
+    int        nverts = config.vert.used;
+    int        p, v, i, n, left;
+
+    limit = ls->opt.step_budget ? ls->opt.step_budget : (uint64_t)LOCAL_MAX_MOVES * nverts;
+    for(;;) {
+        for(p = 0, left = 0, *moves = 0; p < ls->nparts; p++) {
+            left   += ls->part[p].ninner + ls->part[p].nouter;
+            *moves += ls->part[p].moves;
+        }
+        if(!left || *moves >= limit || (ls->opt.deadline && solver_clock() >= ls->opt.deadline))
+            break;
+
+        ls->round = (limit - *moves + ls->nparts - 1) / ls->nparts < LOCAL_ROUND_MOVES
+            ? (int)((limit - *moves + ls->nparts - 1) / ls->nparts) : LOCAL_ROUND_MOVES;
+        workpool_run(nthreads, ls->nparts, local_inner, ls);
+
+        // Border vertices may touch other partitions, so they are
+        // repaired on this thread, as many moves as were listed.
+
+        for(p = 0; p < ls->nparts; p++) {
+            lp = ls->part + p;
+            for(i = 0, n = lp->nouter; i < n && lp->nouter; i++)
+                local_move(ls, lp, lp->outer[local_draw(lp) % lp->nouter]);
+        }
+    }
+
+    // Only movable vertices are listed, so success is judged by the edges
+    // themselves rather than by left.
+
+    for(v = 0; v < nverts && !ls->conf[v]; v++);
+    if(v == nverts)
+        return SOLVE_OK;
+
+    for(v = 0; v < nverts; v++)
+        if(ls->conf[v])
+            ls->tiles[v] = -1;
+    return SOLVE_BUDGET;
+}
+
+
+//==============================================================================
+// Assigns a tile to every vertex of config.vert by local search on nthreads
+// threads, using the seed, step budget and deadline in opt; without a step
+// budget, the search makes up to LOCAL_MAX_MOVES moves per vertex. Returns
+// SOLVE_OK if tiles receives a full assignment without mismatches, or
+// SOLVE_BUDGET if the moves or the time ran out first, in which case tiles
+// holds -1 for every vertex that still has a mismatched edge. Returns
+// SOLVE_UNSAT if some vertex has no eligible tile that fits its borders, or if
+// two neighbors that each have a single one mismatch. moves receives the
+// number of moves made.
+//==============================================================================
+
+int local_solve(SolverOptions *opt, int nthreads, int *tiles, uint64_t *moves) {
+    LocalSearch ls;
+    LocalPart  *lp;
+    int         nverts = config.vert.used;
+    int         p, v, u, result;
+
+    memset(&ls, 0, sizeof(LocalSearch));
+    ls.opt    = *opt;
+    ls.tiles  = tiles;
+    ls.nparts = (nverts + LOCAL_PART_VERTS - 1) / LOCAL_PART_VERTS;
+    ls.conf       = malloc(sizeof(uint8_t) * nverts);
+    ls.flags      = malloc(sizeof(uint8_t) * nverts);
+    ls.slot       = malloc(sizeof(int) * nverts);
+    ls.tabu_tile  = malloc(sizeof(int) * nverts);
+    ls.tabu_until = calloc(nverts, sizeof(uint32_t));
+    ls.part       = calloc(ls.nparts, sizeof(LocalPart));
+    if(!ls.conf || !ls.flags || !ls.slot || !ls.tabu_tile || !ls.tabu_until || (ls.nparts && !ls.part)) {
+        printf("Unable to allocate local search state.\n");
+        abort();
+    }
+
+    for(p = 0; p < ls.nparts; p++) {
+        lp = ls.part + p;
+        lp->first = p * LOCAL_PART_VERTS;
+        lp->last  = lp->first + LOCAL_PART_VERTS < nverts ? lp->first + LOCAL_PART_VERTS : nverts;
+        lp->seed  = rng_u64(opt->seed, LOCAL_RNG_STREAM, p);
+        lp->inner = malloc(sizeof(int) * (lp->last - lp->first));
+        lp->outer = malloc(sizeof(int) * (lp->last - lp->first));
+        if(!lp->inner || !lp->outer) {
+            printf("Unable to allocate local search state.\n");
+            abort();
+        }
+    }
+
+    workpool_run(nthreads, ls.nparts, local_start, &ls);
+    for(v = 0; v < nverts && tiles[v] >= 0; v++);
+
+    *moves = 0;
+    if(v < nverts) {
+        fprintf(stderr, "Vertex %d has no eligible tile that fits its borders.\n", v);
+        result = SOLVE_UNSAT;
+    } else {
+        workpool_run(nthreads, ls.nparts, local_count, &ls);
+        for(v = 0, u = -1; v < nverts && (u = local_stuck(&ls, v)) < 0; v++);
+
+        if(u >= 0) {
+            fprintf(stderr, "Vertices %d and %d each have a single tile that fits, and the two do not mate.\n", v, u);
+            result = SOLVE_UNSAT;
+        } else {
+            result = local_search(&ls, nthreads, moves);
+        }
+    }
+
+    for(p = 0; p < ls.nparts; p++) {
+        free(ls.part[p].inner);
+        free(ls.part[p].outer);
+    }
+    free(ls.part);
+    free(ls.conf);
+    free(ls.flags);
+    free(ls.slot);
+    free(ls.tabu_tile);
+    free(ls.tabu_until);
+
+    return result;
+}
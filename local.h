@@ -0,0 +1,78 @@
+#ifndef LOCAL_H
+#define LOCAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rng.h"
+#include "solver.h"
+
+//##############################################################################
+//# Min-conflicts local search, an alternative to the systematic solver for
+//# huge, loosely constrained lattices. Every vertex starts out with a random
+//# tile that fits its borders, and then vertices with a mismatched edge are
+//# repeatedly moved to the tile that mismatches the fewest neighbors. A vertex
+//# may not return to the tile it just left for LOCAL_TABU moves, which keeps
+//# the search from cycling on a plateau, unless every other tile is tabu. The
+//# search cannot prove that a config is unsatisfiable, beyond spotting a
+//# mismatch between two vertices that each have a single tile that fits; it
+//# simply stops once its move allowance runs out.
+//#
+//# The vertices are split into partitions of LOCAL_PART_VERTS consecutive
+//# indices, which for a generated lattice are bands of whole rows. In each
+//# round, the partitions repair their inner vertices, those whose neighbors
+//# are all in the same partition, in parallel. Since such a move only touches
+//# the partition's own vertices, the partitions need no locking. The vertices
+//# on partition borders are then repaired one partition after the other. The
+//# partitions do not depend on the thread count, and each draws its random
+//# numbers from its own stream, so the result does not either.
+//##############################################################################
+
+#define LOCAL_PART_VERTS  (1 << 18)  // vertices per partition
+#define LOCAL_ROUND_MOVES (1 << 16)  // moves per partition between border repairs
+#define LOCAL_TABU        8          // moves of its partition for which a vertex may not
+                                     // return to the tile it left
+#define LOCAL_MAX_MOVES   1000       // default move allowance per vertex
+#define LOCAL_RNG_STREAM  (RNG_STREAM_BASE + 2)  // rng.h stream for per-partition seeds
+
+#define LOCAL_MOVABLE 1              // LocalSearch.flags: more than one tile fits the borders
+#define LOCAL_OUTER   2              // LocalSearch.flags: a neighbor is in another partition
+
+typedef struct {             // A range of vertices and those of them with mismatched edges
+    int       first;             // first vertex of the range
+    int       last;              // one past the last vertex
+    int      *inner;             // movable vertices with a mismatch and no outer neighbor
+    int       ninner;
+    int      *outer;             // movable vertices with a mismatch and an outer neighbor
+    int       nouter;
+    uint64_t  seed;              // seed of the partition's random numbers
+    uint64_t  draws;             // random numbers drawn so far
+    uint32_t  clock;             // moves made so far, the time base of tabu tenures
+    uint64_t  moves;             // same, but does not wrap around
+} LocalPart;
+
+typedef struct {             // Shared state for local search jobs
+    SolverOptions opt;           // seed, step_budget and deadline are used
+    int          *tiles;         // current tile of every vertex
+    uint8_t      *conf;          // number of mismatched edges at every vertex
+    uint8_t      *flags;         // LOCAL_* flags of every vertex
+    int          *slot;          // position in its partition's inner or outer list, -1 if in neither
+    int          *tabu_tile;     // tile each vertex left last, -1 if none
+    uint32_t     *tabu_until;    // partition clock at which that tile is allowed again
+    LocalPart    *part;
+    int           nparts;
+    int           round;         // moves per partition in the current round
+} LocalSearch;
+
+
+// Prototypes ==================================================================
+
+void local_count(int job, void *ctx);
+void local_inner(int job, void *ctx);
+void local_move(LocalSearch *ls, LocalPart *lp, int v);
+int  local_search(LocalSearch *ls, int nthreads, uint64_t *moves);
+int  local_solve(SolverOptions *opt, int nthreads, int *tiles, uint64_t *moves);
+void local_start(int job, void *ctx);
+void local_update(LocalSearch *ls, int v);
+
+#endif // LOCAL_H
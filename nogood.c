@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nogood.h"
+
+//##############################################################################
+//# Learned nogood cache.
+//##############################################################################
+
+
+//==============================================================================
+// Sets up an empty cache that holds up to capacity nogoods. A capacity of 0
+// disables it.
+//==============================================================================
+
+void nogood_init(NogoodCache *nc, int capacity) {
+    memset(nc, 0, sizeof(NogoodCache));
+    nc->capacity = capacity;
+    nc->head     = -1;
+    nc->tail     = -1;
+}
+
+
+//==============================================================================
+// Releases the cache's storage and disables it.
+//==============================================================================
+
+void nogood_free(NogoodCache *nc) {
+    free(nc->nlits);
+    free(nc->vertex);
+    free(nc->tile);
+    free(nc->hash);
+    free(nc->prev);
+    free(nc->next);
+    free(nc->lit_head);
+    free(nc->lit_next);
+    free(nc->set_head);
+    free(nc->set_next);
+    nogood_init(nc, 0);
+}
+
+
+//==============================================================================
+// Allocates the storage of an enabled cache, which nogood_add() does when the
+// first nogood arrives.
+//==============================================================================
+
+void nogood_alloc(NogoodCache *nc) {
+    int nb;
+
+    for(nb = 1; nb < 2 * nc->capacity; nb *= 2)
+        ;
+    nc->mask     = nb - 1;
+    nc->nlits    = malloc(sizeof(int) * nc->capacity);
+    nc->vertex   = malloc(sizeof(int) * nc->capacity * NOGOOD_MAX_LITS);
+    nc->tile     = malloc(sizeof(int) * nc->capacity * NOGOOD_MAX_LITS);
+    nc->hash     = malloc(sizeof(uint64_t) * nc->capacity);
+    nc->prev     = malloc(sizeof(int) * nc->capacity);
+    nc->next     = malloc(sizeof(int) * nc->capacity);
+    nc->lit_head = malloc(sizeof(int) * nb);
+    nc->lit_next = malloc(sizeof(int) * nc->capacity * NOGOOD_MAX_LITS);
+    nc->set_head = malloc(sizeof(int) * nb);
+    nc->set_next = malloc(sizeof(int) * nc->capacity);
+    if(!nc->nlits || !nc->vertex || !nc->tile || !nc->hash || !nc->prev || !nc->next
+            || !nc->lit_head || !nc->lit_next || !nc->set_head || !nc->set_next) {
+        printf("Unable to allocate nogood cache.\n");
+        abort();
+    }
+    memset(nc->lit_head, 0xFF, sizeof(int) * nb);
+    memset(nc->set_head, 0xFF, sizeof(int) * nb);
+}
+
+
+//==============================================================================
+// Adds the nogood made of the nlits literals (vertex[i], tile[i]), unless it
+// is already cached, in which case it only becomes the most recently used.
+// The arrays are sorted by vertex in place. Nogoods with more than
+// NOGOOD_MAX_LITS literals are ignored. Returns true if the nogood was new.
+//==============================================================================
+
+bool nogood_add(NogoodCache *nc, int nlits, int *vertex, int *tile) {
+    uint64_t h = 0;
+    int      i, j, v, t, n, b, occ;
+
+    if(!nc->capacity || nlits < 1 || nlits > NOGOOD_MAX_LITS)
+        return false;
+
+    for(i = 1; i < nlits; i++) {
+        v = vertex[i];
+        t = tile[i];
+        for(j = i; j > 0 && vertex[j - 1] > v; j--) {
+            vertex[j] = vertex[j - 1];
+            tile[j]   = tile[j - 1];
+        }
+        vertex[j] = v;
+        tile[j]   = t;
+    }
+    for(i = 0; i < nlits; i++)
+        h = rng_mix(h + nogood_lit_hash(vertex[i], tile[i]));
+
+    if(!nc->nlits)
+        nogood_alloc(nc);
+
+    // Already known?
+
+    for(n = nc->set_head[h & nc->mask]; n >= 0; n = nc->set_next[n]) {
+        if(nc->hash[n] != h || nc->nlits[n] != nlits)
+            continue;
+        for(i = 0; i < nlits; i++)
+            if(nc->vertex[n * NOGOOD_MAX_LITS + i] != vertex[i] || nc->tile[n * NOGOOD_MAX_LITS + i] != tile[i])
+                break;
+        if(i == nlits) {
+            nogood_touch(nc, n);
+            return false;
+        }
+    }
+
+    n = nc->used < nc->capacity ? nc->used++ : nogood_evict(nc);
+
+    nc->nlits[n] = nlits;
+    nc->hash[n]  = h;
+    for(i = 0; i < nlits; i++) {
+        occ = n * NOGOOD_MAX_LITS + i;
+        nc->vertex[occ] = vertex[i];
+        nc->tile[occ]   = tile[i];
+        b = nogood_lit_hash(vertex[i], tile[i]) & nc->mask;
+        nc->lit_next[occ] = nc->lit_head[b];
+        nc->lit_head[b]   = occ;
+    }
+
+    b = h & nc->mask;
+    nc->set_next[n] = nc->set_head[b];
+    nc->set_head[b] = n;
+
+    nc->prev[n] = -1;
+    nc->next[n] = nc->head;
+    if(nc->head >= 0)
+        nc->prev[nc->head] = n;
+    nc->head = n;
+    if(nc->tail < 0)
+        nc->tail = n;
+
+    return true;
+}
+
+
+//==============================================================================
+// Removes the least recently used nogood from every index and returns its
+// slot, which the caller must fill and relink. The cache must not be empty.
+//==============================================================================
+
+int nogood_evict(NogoodCache *nc) {
+    int  n = nc->tail;
+    int  i, occ, *p;
+
+    for(i = 0; i < nc->nlits[n]; i++) {
+        occ = n * NOGOOD_MAX_LITS + i;
+        p = nc->lit_head + (nogood_lit_hash(nc->vertex[occ], nc->tile[occ]) & nc->mask);
+        while(*p != occ)
+            p = nc->lit_next + *p;
+        *p = nc->lit_next[occ];
+    }
+
+    p = nc->set_head + (nc->hash[n] & nc->mask);
+    while(*p != n)
+        p = nc->set_next + *p;
+    *p = nc->set_next[n];
+
+    nc->tail = nc->prev[n];
+    if(nc->tail >= 0)
+        nc->next[nc->tail] = -1;
+    else
+        nc->head = -1;
+
+    return n;
+}
+
+
+//==============================================================================
+// Returns the first occurrence of the literal (vertex, tile) in the cache, or
+// -1 if there is none. The nogood it belongs to is occ / NOGOOD_MAX_LITS.
+//==============================================================================
+
+int nogood_first(NogoodCache *nc, int vertex, int tile) {
+    if(!nc->nlits)
+        return -1;
+    return nogood_next(nc, nc->lit_head[nogood_lit_hash(vertex, tile) & nc->mask], vertex, tile);
+}
+
+
+//==============================================================================
+// Returns the first occurrence of the literal (vertex, tile) at or after occ
+// in its bucket, or -1 if there is none. To continue a scan, pass the
+// successor of the previous result, nc->lit_next[occ].
+//==============================================================================
+
+int nogood_next(NogoodCache *nc, int occ, int vertex, int tile) {
+    for(; occ >= 0; occ = nc->lit_next[occ])
+        if(nc->vertex[occ] == vertex && nc->tile[occ] == tile)
+            return occ;
+    return -1;
+}
+
+
+//==============================================================================
+// Makes the nogood in slot n the most recently used.
+//==============================================================================
+
+void nogood_touch(NogoodCache *nc, int n) {
+    if(nc->head == n)
+        return;
+
+    nc->next[nc->prev[n]] = nc->next[n];
+    if(nc->next[n] >= 0)
+        nc->prev[nc->next[n]] = nc->prev[n];
+    else
+        nc->tail = nc->prev[n];
+
+    nc->prev[n] = -1;
+    nc->next[n] = nc->head;
+    nc->prev[nc->head] = n;
+    nc->head = n;
+}
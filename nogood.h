@@ -0,0 +1,62 @@
+#ifndef NOGOOD_H
+#define NOGOOD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+//##############################################################################
+//# Bounded cache of learned nogoods. A nogood is a small set of literals, each
+//# a vertex and a tile, that cannot all hold at once. Every literal is indexed
+//# in a hash table so that the solver can find the nogoods a vertex takes part
+//# in as soon as it is narrowed to a single tile, and a second table on the
+//# whole literal set keeps duplicates out. Once the cache is full, the least
+//# recently learned or used nogood makes way for a new one. Storage is only
+//# allocated when the first nogood is added, since most small regions never
+//# learn any.
+//##############################################################################
+
+#define NOGOOD_MAX_LITS   8      // conflicts involving more decisions are not kept
+#define NOGOOD_CACHE_SIZE 4096   // default capacity, see SolverOptions.nogoods
+
+typedef struct {
+    int       capacity;      // maximum number of nogoods, 0 if learning is off
+    int       used;          // slots in use
+    int      *nlits;         // number of literals in each slot
+    int      *vertex;        // capacity * NOGOOD_MAX_LITS literal vertices, ascending per slot
+    int      *tile;          // the corresponding tiles
+    uint64_t *hash;          // hash of each slot's literal set
+    int      *prev;          // LRU list, toward the most recently used, -1 at the head
+    int      *next;          // LRU list, toward the least recently used, -1 at the tail
+    int       head;          // most recently used slot, -1 if empty
+    int       tail;          // least recently used slot, -1 if empty
+    int       mask;          // buckets - 1, the bucket count being a power of 2
+    int      *lit_head;      // first literal occurrence in each bucket, -1 if none
+    int      *lit_next;      // next occurrence in the same bucket; occurrence k of slot n is n * NOGOOD_MAX_LITS + k
+    int      *set_head;      // first slot in each bucket of the set table, -1 if none
+    int      *set_next;      // next slot in the same bucket
+} NogoodCache;
+
+
+//==============================================================================
+// Returns the hash of the literal (vertex, tile).
+//==============================================================================
+
+static inline uint64_t nogood_lit_hash(int vertex, int tile) {
+    return rng_mix((uint64_t)(uint32_t)vertex << 32 | (uint32_t)tile);
+}
+
+
+// Prototypes ==================================================================
+
+bool nogood_add(NogoodCache *nc, int nlits, int *vertex, int *tile);
+void nogood_alloc(NogoodCache *nc);
+int  nogood_evict(NogoodCache *nc);
+int  nogood_first(NogoodCache *nc, int vertex, int tile);
+void nogood_free(NogoodCache *nc);
+void nogood_init(NogoodCache *nc, int capacity);
+int  nogood_next(NogoodCache *nc, int occ, int vertex, int tile);
+void nogood_touch(NogoodCache *nc, int n);
+
+#endif // NOGOOD_H
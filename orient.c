@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "orient.h"
+
+//##############################################################################
+//# Expansion of tiles into their distinct orientations.
+//##############################################################################
+
+
+//==============================================================================
+// Pushes tile onto config.tile, followed by a copy for every further distinct
+// orientation allowed by rotate and mirror. The tile becomes the master of
+// the copies and its weight is split evenly among all of them.
+//==============================================================================
+
+void orient_expand(Tile *tile, bool rotate, bool mirror) {
+    Tile    *var, *prev;
+    Surface *side;
+    char    *name;
+    double   weight = tile->weight;
+    int      ndirs = config.dir.used - 1;
+    int      nrot = rotate ? ndirs : 1;
+    int      nframes = nrot * (mirror ? 2 : 1);
+    int      master = config.tile.used;
+    int      f, i, d, src;
+
+    tile->master      = master;
+    tile->orientation = 0;
+    tile->variants    = 1;
+    dynarray_push(&config.tile, tile);
+
+    for(f = 1; f < nframes; f++) {
+        side = calloc(ndirs + 1, sizeof(Surface));
+        if(!side) {
+            printf("Unable to allocate tile sides.\n");
+            abort();
+        }
+
+        // The side now facing d came from d - rotation, reflected first if
+        // this is a mirrored frame.
+
+        for(d = 1; d <= ndirs; d++) {
+            src = ((d - 1) - f % nrot + ndirs) % ndirs;
+            if(f >= nrot)
+                src = (ndirs - src) % ndirs;
+            side[d] = tile->side[src + 1];
+            side[d].direction = d;
+        }
+
+        for(i = 0; i < tile->variants; i++) {
+            prev = config.tile.ary[master + i];
+            for(d = 1; d <= ndirs; d++)
+                if(!surface_equal(&side[d], &prev->side[d]))
+                    break;
+            if(d > ndirs)
+                break;
+        }
+        if(i < tile->variants) {
+            free(side);
+            continue;
+        }
+
+        var = malloc(sizeof(Tile));
+        name = malloc(strlen(tile->name) + 12);
+        if(!var || !name) {
+            printf("Unable to allocate tile.\n");
+            abort();
+        }
+        *var = *tile;
+        sprintf(name, "%s@%d", tile->name, f);
+        var->name        = name;
+        var->side        = side;
+        var->filename    = copy_string(tile->filename);
+        var->orientation = f;
+        dynarray_push(&config.tile, var);
+        tile->variants++;
+    }
+
+    for(i = 0; i < tile->variants; i++) {
+        var = config.tile.ary[master + i];
+        var->weight   = weight / tile->variants;
+        var->variants = tile->variants;
+    }
+}
+
+
+//==============================================================================
+// Returns true if the two surfaces mate with the same surfaces, apart from
+// the direction they face.
+//==============================================================================
+
+bool surface_equal(Surface *a, Surface *b) {
+    uint32_t *p, *q;
+
+    if(a->match_any != b->match_any || a->endcap != b->endcap)
+        return false;
+    if(a->label != b->label || a->match_labels != b->match_labels)
+        return false;
+    if(a->any_of != b->any_of || a->all_of != b->all_of || a->none_of != b->none_of)
+        return false;
+
+    if(a->match_labels) {
+        for(p = a->labels, q = b->labels; *p && *q; p++, q++)
+            if(*p != *q)
+                return false;
+        if(*p || *q)
+            return false;
+    }
+
+    return true;
+}
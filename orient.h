@@ -0,0 +1,30 @@
+#ifndef ORIENT_H
+#define ORIENT_H
+
+#include <stdbool.h>
+
+#include "tilist.h"
+
+//##############################################################################
+//# Tile orientations. A tile marked "rotate" and/or "mirror" in the config is
+//# expanded into one Tile per distinct orientation, so orientation is just part
+//# of the candidate the solver picks and needs no special handling there. The
+//# config's directions are taken to be clockwise: rotating by one step moves
+//# the side facing direction i to direction i+1, and mirroring reflects the
+//# sides across the axis through the first direction.
+//#
+//# Orientations are numbered like the frames of the sprite sheet, which are
+//# tileWidth apart from left to right: first the rotations by 0..n-1 steps,
+//# or only 0 if the tile does not rotate, then the same for the mirrored tile.
+//# An orientation whose sides all equal those of an earlier one is dropped, so
+//# a symmetric tile does not multiply the domain size; the earlier orientation's
+//# frame is drawn for it. The remaining orientations are stored contiguously
+//# after the tile itself, named "name@frame", and share the tile's weight.
+//##############################################################################
+
+// Prototypes ==================================================================
+
+void orient_expand(Tile *tile, bool rotate, bool mirror);
+bool surface_equal(Surface *a, Surface *b);
+
+#endif // ORIENT_H
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "portfolio.h"
+#include "workpool.h"
+
+//##############################################################################
+//# Multi-threaded portfolio solver.
+//##############################################################################
+
+
+//==============================================================================
+// Races nworkers solvers on nthreads threads and waits for the winner. Worker 0
+// uses the base options unchanged; the others derive theirs from it with
+// portfolio_options(). On SOLVE_OK, the winning assignment for the region in
+// base->region is copied to tiles, which is indexed by config.vert. The
+// winner's counters are copied to stats either way. Worker 0 is set up on the
+// calling thread first, so that a config which fails solver_init() is reported
+// once rather than once per worker, and with a single worker the search simply
+// runs to completion on the caller, unless checkpoints are being taken, which
+// happens between epochs.
+//
+// Running out of budget is no verdict, so the race goes on until every worker
+// has run out. The result is then SOLVE_BUDGET, and the worker with the most
+// vertices assigned in its best partial assignment counts as the winner and
+// copies that assignment to tiles, with -1 for the vertices left open.
+//==============================================================================
+
+int portfolio_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats) {
+    Portfolio        pf;
+    PortfolioWorker *w;
+    int              i, v, result;
+
+    pf.nworkers = nworkers;
+    pf.winner   = nworkers;
+    pf.epoch    = nworkers > 1 || checkpoint.fname ? PORTFOLIO_EPOCH : 0;
+    pf.worker   = calloc(nworkers, sizeof(PortfolioWorker));
+    if(!pf.worker) {
+        printf("Unable to allocate portfolio workers.\n");
+        abort();
+    }
+    pthread_mutex_init(&pf.lock, NULL);
+
+    for(i = 0; i < nworkers; i++) {
+        w = pf.worker + i;
+        w->pf = &pf;
+        w->id = i;
+        portfolio_options(&w->opt, base, i);
+        if(nworkers > 1)
+            w->opt.cancel = &w->cancel;
+    }
+
+    pf.worker[0].ready = true;
+    if(!solver_init(&pf.worker[0].sv, &pf.worker[0].opt)) {
+        memset(stats, 0, sizeof(SolverStats));
+        solver_free(&pf.worker[0].sv);
+        free(pf.worker);
+        pthread_mutex_destroy(&pf.lock);
+        return SOLVE_UNSAT;
+    }
+
+    if(!checkpoint_restore(&pf, base->region)) {
+        for(i = 0; i < nworkers; i++) {
+            solver_free(&pf.worker[i].sv);
+            pf.worker[i].ready = false;
+        }
+        pf.worker[0].ready = true;
+        solver_init(&pf.worker[0].sv, &pf.worker[0].opt);
+    }
+
+    for(;;) {
+        workpool_run(nthreads, nworkers, portfolio_step, &pf);
+        if(pf.winner < nworkers)
+            break;
+        for(i = 0; i < nworkers && pf.worker[i].result == SOLVE_BUDGET; i++)
+            ;
+        if(i == nworkers) {
+            for(i = pf.winner = 0; i < nworkers; i++)
+                if(pf.worker[i].sv.best > pf.worker[pf.winner].sv.best)
+                    pf.winner = i;
+            checkpoint_capture(&pf, base->region);
+            break;
+        }
+        checkpoint_poll(&pf, base->region);
+    }
+
+    w = pf.worker + pf.winner;
+    result = w->result;
+    *stats = w->sv.stats;
+    if(result == SOLVE_OK) {
+        for(v = 0; v < w->sv.nverts; v++)
+            tiles[w->sv.vert[v]] = solver_tile(&w->sv, v);
+    } else if(result == SOLVE_BUDGET) {
+        for(v = 0; v < w->sv.nverts; v++)
+            tiles[w->sv.vert[v]] = w->sv.best_tile[v];
+    }
+
+    for(i = 0; i < nworkers; i++)
+        solver_free(&pf.worker[i].sv);
+    free(pf.worker);
+    pthread_mutex_destroy(&pf.lock);
+
+    return result;
+}
+
+
+//==============================================================================
+// Fills in the options for worker id. Worker 0 runs the base options as they
+// are; the rest cycle through MRV with random values, MRV with random values
+// and Luby restarts, and Vertices.order with random values and geometric
+// restarts, each with its own seed derived from the base seed.
+//==============================================================================
+
+void portfolio_options(SolverOptions *opt, SolverOptions *base, int id) {
+    *opt = *base;
+    if(!id)
+        return;
+
+    opt->seed = base->seed + (uint64_t)id * 0x9E3779B97F4A7C15ULL;
+
+    opt->random_values = true;
+    switch(id % 3) {
+        case 1:
+            opt->select = SELECT_MRV;
+            break;
+        case 2:
+            opt->select = SELECT_MRV;
+            opt->restart_base = SOLVER_RESTART_BASE;
+            opt->restart = RESTART_LUBY;
+            break;
+        default:
+            opt->select = SELECT_ORDER;
+            opt->restart_base = SOLVER_RESTART_BASE;
+            opt->restart = RESTART_GEOMETRIC;
+            break;
+    }
+}
+
+
+//==============================================================================
+// Worker pool job: advances worker job by one epoch, setting it up first if
+// necessary. Every search in the portfolio is complete, so SOLVE_UNSAT is as
+// final as SOLVE_OK. A worker that finishes becomes the winner unless a
+// lower-numbered one already has, and cancels the higher-numbered workers,
+// which can no longer win. Lower-numbered workers finish their epoch, since
+// they may still take precedence.
+//==============================================================================
+
+void portfolio_step(int job, void *ctx) {
+    Portfolio       *pf = ctx;
+    PortfolioWorker *w  = pf->worker + job;
+    int              i;
+
+    if(!w->ready) {
+        w->ready = true;
+        if(!solver_init(&w->sv, &w->opt))
+            w->sv.result = SOLVE_UNSAT;
+    }
+
+    w->result = solver_run(&w->sv, pf->epoch);
+    if(w->result == SOLVE_PAUSED || w->result == SOLVE_CANCELLED || w->result == SOLVE_BUDGET)
+        return;
+
+    pthread_mutex_lock(&pf->lock);
+    if(job < pf->winner) {
+        pf->winner = job;
+        for(i = job + 1; i < pf->nworkers; i++)
+            __atomic_store_n(&pf->worker[i].cancel, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&pf->lock);
+}
@@ -0,0 +1,51 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "solver.h"
+
+//##############################################################################
+//# Portfolio solving: several independently configured solvers race over the
+//# shared, read-only config and compat tables, and the first one to reach a
+//# verdict cancels the rest.
+//#
+//# "First" is measured in search steps rather than wall time, so the outcome is
+//# reproducible: the solvers advance in epochs of PORTFOLIO_EPOCH steps, and
+//# the winner is the lowest-numbered worker to finish in the earliest epoch in
+//# which any worker finishes. The result depends only on the base options and
+//# the number of workers, not on the number of threads running them.
+//##############################################################################
+
+#define PORTFOLIO_EPOCH        4096  // search steps per worker between winner checks
+
+struct Portfolio;
+
+typedef struct {
+    struct Portfolio *pf;            // shared state
+    int               id;            // worker number, 0 being the baseline solver
+    SolverOptions     opt;
+    Solver            sv;
+    bool              ready;         // solver_init() has been called
+    int               result;        // SOLVE_* result of the last epoch
+    volatile int      cancel;        // raised when a lower-numbered worker finishes this epoch
+} PortfolioWorker;
+
+typedef struct Portfolio {
+    PortfolioWorker  *worker;        // array of nworkers workers
+    int               nworkers;
+    int               winner;        // lowest worker id to finish so far, nworkers if none
+    uint64_t          epoch;         // search steps per epoch, 0 to run each worker to the end
+    pthread_mutex_t   lock;          // guards winner and the cancel flags
+} Portfolio;
+
+
+// Prototypes ==================================================================
+
+void portfolio_options(SolverOptions *opt, SolverOptions *base, int id);
+int  portfolio_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats);
+void portfolio_step(int job, void *ctx);
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "count.h"
+#include "portfolio.h"
+#include "region.h"
+#include "workpool.h"
+
+//##############################################################################
+//# Independent region decomposition and parallel solving.
+//##############################################################################
+
+Regions regions;
+
+
+//==============================================================================
+// Splits config.vert into regions. Must be called after parse_config() and
+// before any solver_init(). If pin is not NULL, it holds a tile for every
+// vertex that is to keep it, or -1; such vertices must already fit their own
+// constraints and each other. Regions are numbered in order of their lowest
+// vertex, so the decomposition depends only on the config and pin. Returns
+// boolean success.
+//==============================================================================
+
+bool region_build(int *pin) {
+    int32_t *nbr;
+    int      nverts = config.vert.used, ndirs = config.dir.used - 1;
+    int     *stack, *pos;
+    int      v, u, w, d, r, sp, kind, free_r = -1;
+
+    region_free();
+
+    regions.id    = malloc(sizeof(int) * nverts);
+    regions.local = malloc(sizeof(int) * nverts);
+    regions.vert  = malloc(sizeof(int) * nverts);
+    regions.start = malloc(sizeof(int) * (nverts + 1));
+    regions.kind  = malloc(sizeof(int) * nverts);
+    stack         = malloc(sizeof(int) * nverts);
+    if(!regions.id || !regions.local || !regions.vert || !regions.start || !regions.kind || !stack) {
+        printf("Unable to allocate regions.\n");
+        abort();
+    }
+    if(pin) {
+        regions.pin = malloc(sizeof(int) * nverts);
+        if(!regions.pin) {
+            printf("Unable to allocate regions.\n");
+            abort();
+        }
+        memcpy(regions.pin, pin, sizeof(int) * nverts);
+    }
+
+    for(v = 0; v < nverts; v++)
+        regions.id[v] = -1;
+
+    // Flood fill across edges whose ends are of the same kind. Tile-count
+    // limits tie all free vertices together, wherever they are.
+
+    for(v = 0; v < nverts; v++) {
+        if(regions.id[v] >= 0)
+            continue;
+
+        kind = region_kind(v);
+        r    = kind == REGION_FREE && counts.nlimits && free_r >= 0 ? free_r : regions.nregions++;
+        if(kind == REGION_FREE)
+            free_r = r;
+        regions.id[v]   = r;
+        regions.kind[r] = kind;
+        stack[0] = v;
+        sp = 1;
+
+        while(sp) {
+            u   = stack[--sp];
+            nbr = vertex_neighbors(&config.vert, u);
+
+            for(d = 1; d <= ndirs; d++) {
+                w = nbr[d - 1];
+                if(w < 0 || regions.id[w] >= 0 || region_kind(w) != kind)
+                    continue;
+                regions.id[w] = r;
+                stack[sp++] = w;
+            }
+        }
+    }
+    free(stack);
+
+    // Group the vertices by region with a counting sort.
+
+    memset(regions.start, 0, sizeof(int) * (regions.nregions + 1));
+    for(v = 0; v < nverts; v++)
+        regions.start[regions.id[v] + 1]++;
+    for(r = 0; r < regions.nregions; r++)
+        regions.start[r + 1] += regions.start[r];
+
+    pos = malloc(sizeof(int) * (regions.nregions + 1));
+    if(!pos) {
+        printf("Unable to allocate regions.\n");
+        abort();
+    }
+    memcpy(pos, regions.start, sizeof(int) * (regions.nregions + 1));
+
+    for(v = 0; v < nverts; v++) {
+        r = regions.id[v];
+        regions.local[v] = pos[r] - regions.start[r];
+        regions.vert[pos[r]++] = v;
+    }
+    free(pos);
+
+    return true;
+}
+
+
+//==============================================================================
+// Returns the tile that vertex v is fixed to, either by pinning or by an
+// eligible list of exactly one tile, or -1 if it is free.
+//==============================================================================
+
+int region_fixed(int v) {
+    int *elig, cnt;
+
+    if(regions.pin && regions.pin[v] >= 0)
+        return regions.pin[v];
+    elig = vertex_eligible(&config.vert, v, &cnt);
+    return cnt == 1 ? elig[0] : -1;
+}
+
+
+//==============================================================================
+// Assigns every vertex of fixed region r its one tile in tiles, and checks
+// that it fits its borders and its fixed or pinned neighbors. Free neighbors
+// check the pair from their side. Returns SOLVE_OK, or SOLVE_UNSAT after
+// reporting the first vertex that does not fit.
+//==============================================================================
+
+int region_assign(int r, int *tiles) {
+    int32_t *nbr;
+    int      i, v, u, d, t;
+
+    for(i = regions.start[r]; i < regions.start[r + 1]; i++) {
+        v   = regions.vert[i];
+        t   = region_fixed(v);
+        nbr = vertex_neighbors(&config.vert, v);
+
+        for(d = 1; d <= compat.ndirs; d++) {
+            u = nbr[d - 1];
+            if(u == -1 ? !bitset_test(compat_border(d), t)
+                    : u >= 0 && region_kind(u) != REGION_FREE && !bitset_test(compat_row(t, d), region_fixed(u)))
+                break;
+        }
+        if(d <= compat.ndirs || !bitset_test(compat.live, t)) {
+            fprintf(stderr, "Vertex %d has no eligible tile that fits its borders and fixed neighbors.\n", v);
+            return SOLVE_UNSAT;
+        }
+        tiles[v] = t;
+    }
+
+    return SOLVE_OK;
+}
+
+
+//==============================================================================
+// Returns the REGION_* kind of vertex v.
+//==============================================================================
+
+int region_kind(int v) {
+    if(regions.pin && regions.pin[v] >= 0)
+        return REGION_PINNED;
+    return region_fixed(v) >= 0 ? REGION_FIXED : REGION_FREE;
+}
+
+
+//==============================================================================
+// Releases the region tables.
+//==============================================================================
+
+void region_free(void) {
+    free(regions.start);
+    free(regions.vert);
+    free(regions.id);
+    free(regions.local);
+    free(regions.kind);
+    free(regions.pin);
+    memset(&regions, 0, sizeof(Regions));
+}
+
+
+//==============================================================================
+// Worker pool job: solves region job with its own portfolio, unless another
+// region has already turned out to be unsatisfiable. Pinned regions simply
+// keep their tiles, and so do regions solved before a resumed checkpoint.
+// Fixed regions get their tiles from region_assign(), and a free region of a
+// single vertex, which has nothing to race over, is left to one solver.
+//==============================================================================
+
+void region_job(int job, void *ctx) {
+    RegionSolve  *rs  = ctx;
+    SolverOptions opt = rs->opt;
+    SolverStats   stats;
+    int           res, i;
+    bool          one;
+
+    if(regions.kind[job] == REGION_PINNED) {
+        for(i = regions.start[job]; i < regions.start[job + 1]; i++)
+            rs->tiles[regions.vert[i]] = regions.pin[regions.vert[i]];
+        return;
+    }
+    if(__atomic_load_n(&rs->failed, __ATOMIC_RELAXED))
+        return;
+
+    memset(&stats, 0, sizeof(SolverStats));
+    if(regions.kind[job] == REGION_FIXED) {
+        res = region_assign(job, rs->tiles);
+    } else if(checkpoint_solved(job, rs->tiles, &stats)) {
+        res = SOLVE_OK;
+    } else {
+        opt.region = job;
+        one = regions.start[job + 1] - regions.start[job] == 1;
+        res = portfolio_solve(&opt, one ? 1 : rs->nworkers, one ? 1 : rs->nthreads, rs->tiles, &stats);
+        if(res == SOLVE_OK)
+            checkpoint_done(job, rs->tiles, &stats);
+    }
+
+    pthread_mutex_lock(&rs->lock);
+    solver_add_stats(rs->stats, &stats);
+    if(res == SOLVE_BUDGET) {
+        if(rs->result == SOLVE_OK)
+            rs->result = res;
+    } else if(res != SOLVE_OK) {
+        rs->result = res;
+        __atomic_store_n(&rs->failed, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&rs->lock);
+}
+
+
+//==============================================================================
+// Solves every region with a portfolio of nworkers solvers, using nthreads
+// threads in all. With fewer regions than threads, the spare threads go to the
+// regions' portfolios. On SOLVE_OK, tiles receives the tile of every vertex.
+// On SOLVE_BUDGET, some region ran out of budget, and its vertices receive
+// its best partial assignment, with -1 for those left open; the rest of the
+// regions carry on regardless.
+// stats receives the counters summed over the regions that were solved.
+//==============================================================================
+
+int region_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats) {
+    RegionSolve rs;
+    int         r;
+
+    rs.opt      = *base;
+    rs.nworkers = nworkers;
+    rs.nthreads = regions.nregions && nthreads > regions.nregions ? nthreads / regions.nregions : 1;
+    rs.tiles    = tiles;
+    rs.stats    = stats;
+    rs.failed   = 0;
+    rs.result   = SOLVE_OK;
+    pthread_mutex_init(&rs.lock, NULL);
+
+    memset(stats, 0, sizeof(SolverStats));
+    workpool_run(nthreads, regions.nregions, region_job, &rs);
+
+    // Tile-count limits are enforced by the solver of the free region, so
+    // with none of those, the fixed tiles are counted here.
+
+    for(r = 0; r < regions.nregions && regions.kind[r] != REGION_FREE; r++);
+    if(rs.result == SOLVE_OK && r == regions.nregions && count_tally(tiles, NULL)) {
+        fprintf(stderr, "The fixed tiles break a minCount or maxCount.\n");
+        rs.result = SOLVE_UNSAT;
+    }
+
+    pthread_mutex_destroy(&rs.lock);
+    return rs.result;
+}
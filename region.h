@@ -0,0 +1,64 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "solver.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Decomposition of the lattice into independent regions. Two neighboring
+//# vertices belong to the same region if both are free, or if both are fixed,
+//# i.e., have an eligible list of exactly one tile. A fixed vertex therefore
+//# cuts its free neighbors off from each other: they only have to agree with
+//# its known tile, which each of them can check on its own. Every free region
+//# is then solved by a separate portfolio, and the regions run in parallel. A
+//# fixed region only needs its tiles checked against each other.
+//#
+//# Vertices can also be pinned to a tile known from an earlier solution. They
+//# count as fixed, but form regions of their own that are taken as solved.
+//#
+//# Tile-count limits apply to the whole lattice, so while any are set, all free
+//# vertices form a single region, connected or not; see count.h.
+//##############################################################################
+
+#define REGION_FREE   0      // vertices with a choice of tiles
+#define REGION_FIXED  1      // vertices with an eligible list of one tile
+#define REGION_PINNED 2      // vertices pinned by region_build()
+
+typedef struct {
+    int   nregions;
+    int  *start;             // nregions + 1 offsets into vert
+    int  *vert;              // vertex indices grouped by region, ascending within each
+    int  *id;                // region of each vertex
+    int  *local;             // position of each vertex within its region
+    int  *kind;              // REGION_* of each region
+    int  *pin;               // tile each vertex is pinned to, -1 if none, or NULL
+} Regions;
+
+typedef struct {             // Shared state for region_solve() jobs
+    SolverOptions    opt;        // base options; each job sets opt.region
+    int              nworkers;   // portfolio size per region
+    int              nthreads;   // threads per region
+    int             *tiles;      // assignment, filled in region by region
+    SolverStats     *stats;      // counters summed over the regions
+    volatile int     failed;     // set once some region is unsatisfiable
+    pthread_mutex_t  lock;       // guards stats and the result
+    int              result;
+} RegionSolve;
+
+extern Regions regions;
+
+
+// Prototypes ==================================================================
+
+int  region_assign(int r, int *tiles);
+bool region_build(int *pin);
+int  region_fixed(int v);
+void region_free(void);
+void region_job(int job, void *ctx);
+int  region_kind(int v);
+int  region_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats);
+
+#endif // REGION_H
@@ -0,0 +1,363 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "render.h"
+#include "runstats.h"
+
+//##############################################################################
+//# Sprite loading, compositing and PNG output.
+//##############################################################################
+
+Bitmap render_base;
+
+
+//==============================================================================
+// Decodes every tile's sprite sheet with render_sprites() and prepares the
+// background canvas. Returns boolean success.
+//==============================================================================
+
+bool render_init(void) {
+    Bitmap   bg;
+    unsigned i;
+
+    if(!render_sprites())
+        return false;
+
+    // Background --------------------------------------------------------------
+
+    render_base.width  = config.image_width;
+    render_base.height = config.image_height;
+    render_base.pixels = malloc(sizeof(Pixel) * render_base.width * render_base.height);
+    if(!render_base.pixels) {
+        printf("Unable to allocate background canvas.\n");
+        abort();
+    }
+    for(i = 0; i < render_base.width * render_base.height; i++)
+        render_base.pixels[i] = config.bgcolor;
+
+    if(config.bg_image_filename) {
+        if(!render_load(&bg, config.bg_image_filename))
+            return false;
+        render_blit(&render_base, &bg, 0, 0, bg.width, bg.height, 0, 0);
+        free(bg.pixels);
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Releases the decoded sprites and the background canvas.
+//==============================================================================
+
+void render_free(void) {
+    Tile *tile, *other;
+    int   t, u;
+
+    for(t = config.tile.used - 1; t >= 0; t--) {
+        tile = config.tile.ary[t];
+        for(u = 0; u < t; u++) {
+            other = config.tile.ary[u];
+            if(other->sprite == tile->sprite)
+                break;
+        }
+        if(u == t && tile->sprite) {
+            free(tile->sprite->pixels);
+            free(tile->sprite);
+        }
+        tile->sprite = NULL;
+    }
+
+    free(render_base.pixels);
+    render_base.pixels = NULL;
+}
+
+
+//==============================================================================
+// Decodes the PNG file fname into bmp. Returns boolean success.
+//==============================================================================
+
+bool render_load(Bitmap *bmp, char *fname) {
+    unsigned char *buf;
+    unsigned       err;
+
+    err = lodepng_decode32_file(&buf, &bmp->width, &bmp->height, fname);
+    if(err) {
+        fprintf(stderr, "Unable to load '%s': %s\n", fname, lodepng_error_text(err));
+        return false;
+    }
+    bmp->pixels = (Pixel *)buf;
+
+    return true;
+}
+
+
+//==============================================================================
+// Alpha-blends the w x h region of src at (sx, sy) onto dst at (dx, dy),
+// clipping against dst.
+//==============================================================================
+
+void render_blit(Bitmap *dst, Bitmap *src, int sx, int sy, int w, int h, int dx, int dy) {
+    Pixel   *s, *d;
+    unsigned a, ia;
+    int      x, y;
+
+    if(dx < 0) {
+        sx -= dx;
+        w  += dx;
+        dx  = 0;
+    }
+    if(dy < 0) {
+        sy -= dy;
+        h  += dy;
+        dy  = 0;
+    }
+    if(dx + w > (int)dst->width)
+        w = dst->width - dx;
+    if(dy + h > (int)dst->height)
+        h = dst->height - dy;
+
+    for(y = 0; y < h; y++) {
+        s = src->pixels + (size_t)(sy + y) * src->width + sx;
+        d = dst->pixels + (size_t)(dy + y) * dst->width + dx;
+        for(x = 0; x < w; x++, s++, d++) {
+            a = s->a;
+            if(a == 0xFF) {
+                *d = *s;
+            } else if(a) {
+                ia = 0xFF - a;
+                d->r = (s->r * a + d->r * ia + 127) / 0xFF;
+                d->g = (s->g * a + d->g * ia + 127) / 0xFF;
+                d->b = (s->b * a + d->b * ia + 127) / 0xFF;
+                d->a = a + (d->a * ia + 127) / 0xFF;
+            }
+        }
+    }
+}
+
+
+//==============================================================================
+// Renders the assignment in tiles (one tile per vertex) into canvas, which is
+// allocated here and must be freed. Returns boolean success.
+//==============================================================================
+
+bool render_composite(Bitmap *canvas, int *tiles) {
+    canvas->width  = render_base.width;
+    canvas->height = render_base.height;
+    canvas->pixels = malloc(sizeof(Pixel) * canvas->width * canvas->height);
+    if(!canvas->pixels)
+        return false;
+
+    render_region(canvas, tiles, 0, 0, canvas->width, canvas->height);
+    return true;
+}
+
+
+//==============================================================================
+// Encodes canvas as a PNG and writes it to fname. Returns boolean success.
+//==============================================================================
+
+bool render_encode(Bitmap *canvas, char *fname) {
+    PhaseClock clk;
+    unsigned   err;
+
+    runstats_start(&clk, CLOCK_THREAD_CPUTIME_ID);
+    err = lodepng_encode32_file(fname, (unsigned char *)canvas->pixels, canvas->width, canvas->height);
+    runstats_stop(&clk, PHASE_ENCODE);
+    if(err) {
+        fprintf(stderr, "Unable to write '%s': %s\n", fname, lodepng_error_text(err));
+        return false;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Re-renders the previous solution prev, which the PNG file fname shows, as the
+// assignment in tiles. Only the rectangle covering the sprites of the vertices
+// that changed is redrawn. If fname does not exist, cannot be loaded or does
+// not match the background's size, the whole image is rendered instead. Returns
+// boolean success.
+//==============================================================================
+
+bool render_patch(char *fname, int *prev, int *tiles) {
+    Bitmap   canvas;
+    Tile    *tile;
+    FILE    *fp;
+    bool     bres;
+    int      x0 = render_base.width, y0 = render_base.height, x1 = 0, y1 = 0;
+    int      ntiles = config.tile.used;
+    int      v, i, t, x, y;
+
+    fp = fopen(fname, "rb");
+    if(!fp)
+        return render_write(fname, tiles);
+    fclose(fp);
+
+    if(!render_load(&canvas, fname))
+        return render_write(fname, tiles);
+    if(canvas.width != render_base.width || canvas.height != render_base.height) {
+        free(canvas.pixels);
+        return render_write(fname, tiles);
+    }
+
+    for(v = 0; v < config.vert.used; v++) {
+        if(prev[v] == tiles[v])
+            continue;
+        for(i = 0; i < 2; i++) {
+            t = i ? tiles[v] : prev[v];
+            if(t < 0 || t >= ntiles)
+                continue;
+            tile = config.tile.ary[t];
+            x = config.vert.x[v] - tile->x_offset;
+            y = config.vert.y[v] - tile->y_offset;
+            if(x < x0)
+                x0 = x;
+            if(y < y0)
+                y0 = y;
+            if(x + tile->width > x1)
+                x1 = x + tile->width;
+            if(y + tile->height > y1)
+                y1 = y + tile->height;
+        }
+    }
+
+    if(x0 >= x1 || y0 >= y1) {
+        free(canvas.pixels);
+        return true;
+    }
+
+    render_region(&canvas, tiles, x0, y0, x1, y1);
+
+    bres = render_encode(&canvas, fname);
+    free(canvas.pixels);
+
+    return bres;
+}
+
+
+//==============================================================================
+// Redraws the rectangle from (x0, y0) up to but excluding (x1, y1) of canvas,
+// which has the background's size: the background is restored and every tile
+// in tiles that overlaps the rectangle is drawn, clipped to it. Tiles are
+// drawn in vertex order, each positioned so that its center lands on the
+// vertex.
+//==============================================================================
+
+void render_region(Bitmap *canvas, int *tiles, int x0, int y0, int x1, int y1) {
+    Tile      *tile;
+    PhaseClock clk;
+    int        v, y, dx, dy, sx, sy, w, h;
+
+    if(x0 < 0)
+        x0 = 0;
+    if(y0 < 0)
+        y0 = 0;
+    if(x1 > (int)canvas->width)
+        x1 = canvas->width;
+    if(y1 > (int)canvas->height)
+        y1 = canvas->height;
+    if(x0 >= x1 || y0 >= y1)
+        return;
+
+    runstats_start(&clk, CLOCK_THREAD_CPUTIME_ID);
+
+    for(y = y0; y < y1; y++)
+        memcpy(canvas->pixels + (size_t)y * canvas->width + x0,
+            render_base.pixels + (size_t)y * render_base.width + x0, sizeof(Pixel) * (x1 - x0));
+
+    for(v = 0; v < config.vert.used; v++) {
+        tile = config.tile.ary[tiles[v]];
+        dx = config.vert.x[v] - tile->x_offset;
+        dy = config.vert.y[v] - tile->y_offset;
+        sx = 0;
+        sy = 0;
+        w  = tile->width;
+        h  = tile->height;
+
+        if(dx < x0) {
+            sx = x0 - dx;
+            w -= sx;
+            dx = x0;
+        }
+        if(dy < y0) {
+            sy = y0 - dy;
+            h -= sy;
+            dy = y0;
+        }
+        if(dx + w > x1)
+            w = x1 - dx;
+        if(dy + h > y1)
+            h = y1 - dy;
+        if(w <= 0 || h <= 0)
+            continue;
+
+        render_blit(canvas, tile->sprite, tile->orientation * tile->width + sx, sy, w, h, dx, dy);
+    }
+
+    runstats_stop(&clk, PHASE_COMPOSITE);
+}
+
+
+//==============================================================================
+// Decodes every tile's sprite sheet. Tiles that share a sprite sheet share a
+// single decoded Bitmap, which must hold the frame of each tile's orientation.
+// Returns boolean success.
+//==============================================================================
+
+bool render_sprites(void) {
+    Tile *tile, *other;
+    int   t, u, ntiles = config.tile.used;
+
+    for(t = 0; t < ntiles; t++) {
+        tile = config.tile.ary[t];
+
+        for(u = 0; u < t; u++) {
+            other = config.tile.ary[u];
+            if(streq(tile->filename, other->filename)) {
+                tile->sprite = other->sprite;
+                break;
+            }
+        }
+
+        if(!tile->sprite) {
+            tile->sprite = calloc(1, sizeof(Bitmap));
+            if(!tile->sprite) {
+                printf("Unable to allocate sprite.\n");
+                abort();
+            }
+            if(!render_load(tile->sprite, tile->filename))
+                return false;
+        }
+
+        if(tile->sprite->width < (unsigned)(tile->orientation + 1) * tile->width
+                || tile->sprite->height < (unsigned)tile->height) {
+            fprintf(stderr, "Sprite sheet '%s' is smaller than tile '%s'.\n", tile->filename, tile->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Composites the assignment in tiles and writes it to fname as a PNG. Safe to
+// call from several threads at once. Returns boolean success.
+//==============================================================================
+
+bool render_write(char *fname, int *tiles) {
+    Bitmap canvas;
+    bool   bres;
+
+    if(!render_composite(&canvas, tiles)) {
+        fprintf(stderr, "Unable to allocate canvas for '%s'.\n", fname);
+        return false;
+    }
+
+    bres = render_encode(&canvas, fname);
+    free(canvas.pixels);
+
+    return bres;
+}
@@ -0,0 +1,31 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tilist.h"
+
+//##############################################################################
+//# Rendering: sprite loading, compositing of a solved lattice onto the
+//# background, and PNG encoding. render_init() does all of the decoding up
+//# front, after which any number of threads may composite concurrently.
+//##############################################################################
+
+extern Bitmap render_base;   // background color and image, copied for each render
+
+
+// Prototypes ==================================================================
+
+void  render_blit(Bitmap *dst, Bitmap *src, int sx, int sy, int w, int h, int dx, int dy);
+bool  render_composite(Bitmap *canvas, int *tiles);
+bool  render_encode(Bitmap *canvas, char *fname);
+void  render_free(void);
+bool  render_init(void);
+bool  render_load(Bitmap *bmp, char *fname);
+bool  render_patch(char *fname, int *prev, int *tiles);
+void  render_region(Bitmap *canvas, int *tiles, int x0, int y0, int x1, int y1);
+bool  render_sprites(void);
+bool  render_write(char *fname, int *tiles);
+
+#endif // RENDER_H
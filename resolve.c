@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat.h"
+#include "count.h"
+#include "region.h"
+#include "resolve.h"
+
+//##############################################################################
+//# Solution files and incremental re-solving.
+//##############################################################################
+
+
+//==============================================================================
+// Marks the vertices whose tile in tiles no longer fits the config: unknown,
+// pruned or ineligible tiles, sides that need an endcap but lack one, and both
+// ends of every mismatched edge. A tile-count group held too often marks all
+// its holders, and one held too rarely marks every vertex, since the tiles to
+// give up could be anywhere. dist receives 0 for each such vertex and -1 for
+// the rest. Returns the number of invalid vertices. Must be called after
+// compat_build() and count_build().
+//==============================================================================
+
+int resolve_invalid(int *tiles, int *dist) {
+    int32_t *nbr;
+    int     *elig;
+    int     *held = NULL;
+    int      v, u, d, i, t, n, g, cnt = 0;
+
+    for(v = 0; v < config.vert.used; v++) {
+        nbr = vertex_neighbors(&config.vert, v);
+        t   = tiles[v];
+        dist[v] = -1;
+
+        if(t < 0 || t >= compat.ntiles || !bitset_test(compat.live, t)) {
+            dist[v] = 0;
+            continue;
+        }
+        elig = vertex_eligible(&config.vert, v, &n);
+        if(n) {
+            for(i = 0; i < n && elig[i] != t; i++)
+                ;
+            if(i == n)
+                dist[v] = 0;
+        }
+        for(d = 1; d <= compat.ndirs; d++) {
+            if(nbr[d - 1] == -1 && !bitset_test(compat_border(d), t))
+                dist[v] = 0;
+        }
+    }
+
+    for(v = 0; v < config.vert.used; v++) {
+        nbr = vertex_neighbors(&config.vert, v);
+        t   = tiles[v];
+        if(t < 0 || t >= compat.ntiles)
+            continue;
+
+        for(d = 1; d <= compat.ndirs; d++) {
+            u = nbr[d - 1];
+            if(u < 0 || tiles[u] < 0 || tiles[u] >= compat.ntiles)
+                continue;
+            if(!bitset_test(compat_row(t, d), tiles[u])) {
+                dist[v] = 0;
+                dist[u] = 0;
+            }
+        }
+    }
+
+    if(counts.nlimits) {
+        held = malloc(sizeof(int) * counts.nlimits);
+        if(!held) {
+            printf("Unable to allocate tile counters.\n");
+            abort();
+        }
+        if(count_tally(tiles, held)) {
+            for(v = 0; v < config.vert.used; v++) {
+                t = tiles[v];
+                for(g = 0; g < counts.nlimits; g++) {
+                    if(held[g] < counts.limit[g].min
+                            || (held[g] > counts.limit[g].max && t >= counts.limit[g].first && t < counts.limit[g].last))
+                        dist[v] = 0;
+                }
+            }
+        }
+        free(held);
+    }
+
+    for(v = 0; v < config.vert.used; v++)
+        if(!dist[v])
+            cnt++;
+
+    return cnt;
+}
+
+
+//==============================================================================
+// Repairs the previous solution in tiles, in which -1 marks vertices that had
+// none, to fit the current config. Vertices within RESOLVE_RADIUS edges of an
+// invalid one are solved afresh with region_solve() while the rest keep their
+// tiles. If that fails, the radius doubles, until the area takes in all it can
+// reach, i.e., the connected parts of the lattice around the invalid vertices.
+// Parts the area never reaches keep their tiles, so the verdict on the area is
+// final, unless tile-count limits tie it to the rest; the whole lattice is then
+// solved one last time. On SOLVE_OK, tiles holds the repaired solution and area
+// the number of vertices that were solved in the last round; on SOLVE_BUDGET,
+// the round that ran out of budget left a partial repair, with -1 for the
+// vertices it left open. stats receives the counters summed over all rounds.
+// Leaves the regions as region_build(NULL) makes them.
+//==============================================================================
+
+int resolve_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats, int *area) {
+    SolverStats st;
+    int32_t    *nbr;
+    int        *dist, *queue, *pin;
+    int         nverts = config.vert.used;
+    int         v, u, d, head, tail, prev, radius, res;
+    int         ndirs = config.dir.used - 1;
+    bool        hit;
+
+    dist  = malloc(sizeof(int) * nverts);
+    queue = malloc(sizeof(int) * nverts);
+    pin   = malloc(sizeof(int) * nverts);
+    if(!dist || !queue || !pin) {
+        printf("Unable to allocate re-solve state.\n");
+        abort();
+    }
+
+    memset(stats, 0, sizeof(SolverStats));
+    memcpy(pin, tiles, sizeof(int) * nverts);
+    *area = 0;
+    res   = SOLVE_OK;
+
+    if(resolve_invalid(pin, dist)) {
+        for(radius = RESOLVE_RADIUS, prev = -1; ; radius = radius < nverts / 2 ? radius * 2 : nverts) {
+
+            // Breadth-first search outward from the invalid vertices.
+
+            for(v = 0, tail = 0; v < nverts; v++) {
+                if(!dist[v])
+                    queue[tail++] = v;
+                else
+                    dist[v] = -1;
+            }
+            for(head = 0, hit = false; head < tail; head++) {
+                v   = queue[head];
+                nbr = vertex_neighbors(&config.vert, v);
+                if(dist[v] == radius) {
+                    hit = true;
+                    continue;
+                }
+                for(d = 1; d <= ndirs; d++) {
+                    u = nbr[d - 1];
+                    if(u >= 0 && dist[u] < 0) {
+                        dist[u] = dist[v] + 1;
+                        queue[tail++] = u;
+                    }
+                }
+            }
+            *area = tail;
+
+            if(tail == nverts) {
+                region_build(NULL);
+                res = region_solve(base, nworkers, nthreads, tiles, &st);
+                solver_add_stats(stats, &st);
+                break;
+            }
+
+            if(tail != prev) {
+                for(v = 0; v < nverts; v++)
+                    tiles[v] = dist[v] >= 0 ? -1 : pin[v];
+                region_build(tiles);
+                res = region_solve(base, nworkers, nthreads, tiles, &st);
+                solver_add_stats(stats, &st);
+                if(res != SOLVE_UNSAT)
+                    break;
+            }
+
+            // A search that stopped short of the radius, or did not grow, has
+            // taken in all it can reach, so a larger radius would only repeat
+            // this round.
+
+            if(!hit || tail == prev) {
+                if(counts.nlimits) {
+                    *area = nverts;
+                    region_build(NULL);
+                    res = region_solve(base, nworkers, nthreads, tiles, &st);
+                    solver_add_stats(stats, &st);
+                }
+                break;
+            }
+            prev = tail;
+        }
+        region_build(NULL);
+    }
+
+    free(dist);
+    free(queue);
+    free(pin);
+
+    return res;
+}
+
+
+//==============================================================================
+// Completes a partial assignment in tiles, in which -1 marks open vertices,
+// so that it can be rendered. Each open vertex in turn takes the eligible
+// tile that fits the most of its sides, among those compat_prune() left: a
+// side fits if it matches the tile of the neighbor there, or if it is an
+// endcap and there is no neighbor or the neighbor is still open. Ties go to
+// the lowest tile index. Returns the number
+// of vertices filled. Must be called after compat_build().
+//==============================================================================
+
+int solution_fill(int *tiles) {
+    int32_t *nbr;
+    int     *elig;
+    int      v, u, d, i, t, n, fit, best, best_fit, cnt = 0;
+
+    for(v = 0; v < config.vert.used; v++) {
+        if(tiles[v] >= 0)
+            continue;
+        nbr  = vertex_neighbors(&config.vert, v);
+        elig = vertex_eligible(&config.vert, v, &n);
+
+        best = 0;
+        best_fit = -1;
+        for(i = 0; i < (n ? n : compat.ntiles); i++) {
+            t = n ? elig[i] : i;
+            if(!bitset_test(compat.live, t))
+                continue;
+            fit = 0;
+            for(d = 1; d <= compat.ndirs; d++) {
+                u = nbr[d - 1];
+                if(u >= 0 && tiles[u] >= 0)
+                    fit += bitset_test(compat_row(t, d), tiles[u]);
+                else
+                    fit += bitset_test(compat_border(d), t);
+            }
+            if(fit > best_fit || (fit == best_fit && t < best)) {
+                best     = t;
+                best_fit = fit;
+            }
+        }
+
+        tiles[v] = best;
+        cnt++;
+    }
+
+    return cnt;
+}
+
+
+//==============================================================================
+// Loads a solution written by solution_write() into tiles, which receives -1
+// for vertices the file does not name or whose tile no longer exists. Entries
+// for vertices that are no longer in the config are ignored. Returns boolean
+// success.
+//==============================================================================
+
+bool solution_read(char *fname, int *tiles) {
+    NameIndex *vidx, *tidx;
+    cJSON     *json, *sub;
+    char      *buf;
+    int        ntiles = config.tile.used;
+    int        i, v;
+
+    buf = load_file(fname);
+    if(!buf)
+        return false;
+
+    json = cJSON_Parse(buf);
+    free(buf);
+    if(!json || !cJSON_IsObject(json)) {
+        fprintf(stderr, "Solution file '%s' is not a JSON object.\n", fname);
+        cJSON_Delete(json);
+        return false;
+    }
+
+    vidx = malloc(sizeof(NameIndex) * (config.vert.used + 1));
+    tidx = malloc(sizeof(NameIndex) * (ntiles + 1));
+    if(!vidx || !tidx) {
+        printf("Unable to allocate name index.\n");
+        abort();
+    }
+    for(i = 0; i < config.vert.used; i++) {
+        vidx[i].name  = config.vert.name[i];
+        vidx[i].index = i;
+        tiles[i] = -1;
+    }
+    qsort(vidx, config.vert.used, sizeof(NameIndex), compare_names);
+    for(i = 0; i < ntiles; i++) {
+        tidx[i].name  = ((Tile *)config.tile.ary[i])->name;
+        tidx[i].index = i;
+    }
+    qsort(tidx, ntiles, sizeof(NameIndex), compare_names);
+
+    cJSON_ArrayForEach(sub, json) {
+        if(!cJSON_IsString(sub)) {
+            fprintf(stderr, "Tile of vertex '%s' in solution file must be a string.\n", sub->string);
+            free(vidx);
+            free(tidx);
+            cJSON_Delete(json);
+            return false;
+        }
+        v = find_name(vidx, config.vert.used, sub->string);
+        if(v >= 0)
+            tiles[v] = find_name(tidx, ntiles, sub->valuestring);
+    }
+
+    free(vidx);
+    free(tidx);
+    cJSON_Delete(json);
+
+    return true;
+}
+
+
+//==============================================================================
+// Writes the assignment in tiles to fname as a JSON object mapping each
+// vertex name to its tile name. Vertices with -1 for no tile are left out,
+// which solution_read() takes back as -1. Returns boolean success.
+//==============================================================================
+
+bool solution_write(char *fname, int *tiles) {
+    cJSON *json;
+    FILE  *fp;
+    char  *str;
+    int    v, err;
+
+    json = cJSON_CreateObject();
+    if(!json) {
+        printf("Unable to allocate solution.\n");
+        abort();
+    }
+    for(v = 0; v < config.vert.used; v++) {
+        if(tiles[v] < 0)
+            continue;
+        if(!cJSON_AddStringToObject(json, config.vert.name[v],
+                ((Tile *)config.tile.ary[tiles[v]])->name)) {
+            printf("Unable to allocate solution.\n");
+            abort();
+        }
+    }
+
+    str = cJSON_Print(json);
+    cJSON_Delete(json);
+    if(!str) {
+        printf("Unable to allocate solution.\n");
+        abort();
+    }
+
+    fp = fopen(fname, "w");
+    if(!fp) {
+        fprintf(stderr, "Unable to open '%s' for writing.\n", fname);
+        free(str);
+        return false;
+    }
+    err = fputs(str, fp) < 0;
+    err |= fclose(fp) != 0;
+    free(str);
+    if(err) {
+        fprintf(stderr, "Unable to write '%s'.\n", fname);
+        return false;
+    }
+
+    return true;
+}
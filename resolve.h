@@ -0,0 +1,31 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+#include <stdbool.h>
+
+#include "solver.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Solution files and incremental re-solving. A solution is saved as a JSON
+//# object mapping vertex names to tile names, so it survives edits to the
+//# config that add, remove or reorder vertices and tiles. Re-solving starts
+//# from such a solution, finds the vertices whose tiles no longer fit the
+//# edited config, and searches only a neighborhood around them, with the rest
+//# of the lattice pinned to its previous tiles. The neighborhood grows until
+//# the repair succeeds or covers the whole lattice. A solution that a budget
+//# cut short is completed with the best fitting tiles before it is saved.
+//##############################################################################
+
+#define RESOLVE_RADIUS 2     // initial repair radius around invalid vertices, in edges
+
+
+// Prototypes ==================================================================
+
+int  resolve_invalid(int *tiles, int *dist);
+int  resolve_solve(SolverOptions *base, int nworkers, int nthreads, int *tiles, SolverStats *stats, int *area);
+int  solution_fill(int *tiles);
+bool solution_read(char *fname, int *tiles);
+bool solution_write(char *fname, int *tiles);
+
+#endif // RESOLVE_H
@@ -0,0 +1,48 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+//##############################################################################
+//# Counter-based random numbers. Every value is a pure function of a seed, a
+//# stream and a counter, so a draw never depends on how many draws happened
+//# before it elsewhere. Threads, scheduling order and decomposition of the
+//# work therefore have no influence on the results.
+//#
+//# Streams 0..RNG_STREAM_BASE-1 are reserved for per-vertex draws, keyed by
+//# vertex index; other uses take RNG_STREAM_BASE + n.
+//##############################################################################
+
+#define RNG_STREAM_BASE ((uint64_t)1 << 40)
+
+
+//==============================================================================
+// splitmix64 finalizer: a bijective mix with full avalanche.
+//==============================================================================
+
+static inline uint64_t rng_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+//==============================================================================
+// Returns the counter'th 64-bit value of the given stream under seed.
+//==============================================================================
+
+static inline uint64_t rng_u64(uint64_t seed, uint64_t stream, uint64_t counter) {
+    uint64_t z = rng_mix(seed + 0x9E3779B97F4A7C15ULL * (stream + 1));
+    return rng_mix(z + 0xD1B54A32D192ED03ULL * (counter + 1));
+}
+
+
+//==============================================================================
+// As rng_u64(), but returns a double uniformly distributed in [0, 1).
+//==============================================================================
+
+static inline double rng_double(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return (rng_u64(seed, stream, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif // RNG_H
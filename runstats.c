@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cJSON.h"
+#include "runstats.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Run statistics and phase timing.
+//##############################################################################
+
+RunStats runstats = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static char *phase_names[PHASE_COUNT] = {
+    "parse", "setup", "sprites", "solve", "composite", "encode"
+};
+
+
+//==============================================================================
+// Adds the counters of one solve to the totals.
+//==============================================================================
+
+void runstats_solver(SolverStats *stats) {
+    pthread_mutex_lock(&runstats.lock);
+    solver_add_stats(&runstats.solver, stats);
+    runstats.solves++;
+    pthread_mutex_unlock(&runstats.lock);
+}
+
+
+//==============================================================================
+// Starts timing an interval on the calling thread. cpu_clock selects the CPU
+// time that is charged, see runstats.h.
+//==============================================================================
+
+void runstats_start(PhaseClock *clk, clockid_t cpu_clock) {
+    clk->cpu_clock = cpu_clock;
+    clock_gettime(CLOCK_MONOTONIC, &clk->wall);
+    clock_gettime(cpu_clock, &clk->cpu);
+}
+
+
+//==============================================================================
+// Ends the interval started on clk and charges it to phase.
+//==============================================================================
+
+void runstats_stop(PhaseClock *clk, int phase) {
+    struct timespec wall, cpu;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    clock_gettime(clk->cpu_clock, &cpu);
+
+    pthread_mutex_lock(&runstats.lock);
+    runstats.wall[phase] += (wall.tv_sec - clk->wall.tv_sec) + (wall.tv_nsec - clk->wall.tv_nsec) / 1e9;
+    runstats.cpu[phase]  += (cpu.tv_sec - clk->cpu.tv_sec) + (cpu.tv_nsec - clk->cpu.tv_nsec) / 1e9;
+    runstats.calls[phase]++;
+    pthread_mutex_unlock(&runstats.lock);
+}
+
+
+//==============================================================================
+// Writes the statistics gathered so far to fname as JSON. Returns boolean
+// success.
+//==============================================================================
+
+bool runstats_write(char *fname) {
+    SolverStats *st = &runstats.solver;
+    cJSON *json, *sub, *phase;
+    FILE  *fp;
+    char  *str;
+    int    i, err;
+
+    json = cJSON_CreateObject();
+    if(!json) {
+        printf("Unable to allocate statistics.\n");
+        abort();
+    }
+
+    cJSON_AddNumberToObject(json, "threads", config.threads);
+    cJSON_AddNumberToObject(json, "tiles", config.tile.used);
+
+    sub = cJSON_AddObjectToObject(json, "solver");
+    if(!sub) {
+        printf("Unable to allocate statistics.\n");
+        abort();
+    }
+    cJSON_AddNumberToObject(sub, "solves", runstats.solves);
+    cJSON_AddNumberToObject(sub, "decisions", st->decisions);
+    cJSON_AddNumberToObject(sub, "backtracks", st->backtracks);
+    cJSON_AddNumberToObject(sub, "backjumps", st->backjumps);
+    cJSON_AddNumberToObject(sub, "levelsSkipped", st->levels_skipped);
+    cJSON_AddNumberToObject(sub, "restarts", st->restarts);
+    cJSON_AddNumberToObject(sub, "learned", st->learned);
+    cJSON_AddNumberToObject(sub, "nogoodPrunes", st->nogood_prunes);
+    cJSON_AddNumberToObject(sub, "propagations", st->propagations);
+    cJSON_AddNumberToObject(sub, "revisions", st->revisions);
+    cJSON_AddNumberToObject(sub, "pruned", st->pruned);
+    cJSON_AddNumberToObject(sub, "wipeouts", st->wipeouts);
+    cJSON_AddNumberToObject(sub, "peakTrail", st->peak_trail);
+
+    sub = cJSON_AddObjectToObject(json, "phases");
+    if(!sub) {
+        printf("Unable to allocate statistics.\n");
+        abort();
+    }
+    for(i = 0; i < PHASE_COUNT; i++) {
+        phase = cJSON_AddObjectToObject(sub, phase_names[i]);
+        if(!phase) {
+            printf("Unable to allocate statistics.\n");
+            abort();
+        }
+        cJSON_AddNumberToObject(phase, "wall", runstats.wall[i]);
+        cJSON_AddNumberToObject(phase, "cpu", runstats.cpu[i]);
+        cJSON_AddNumberToObject(phase, "calls", runstats.calls[i]);
+    }
+
+    str = cJSON_Print(json);
+    cJSON_Delete(json);
+    if(!str) {
+        printf("Unable to allocate statistics.\n");
+        abort();
+    }
+
+    fp = fopen(fname, "w");
+    if(!fp) {
+        fprintf(stderr, "Unable to open '%s' for writing.\n", fname);
+        free(str);
+        return false;
+    }
+    err = fputs(str, fp) < 0;
+    err |= fclose(fp) != 0;
+    free(str);
+    if(err) {
+        fprintf(stderr, "Unable to write '%s'.\n", fname);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef RUNSTATS_H
+#define RUNSTATS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "solver.h"
+
+//##############################################################################
+//# Run statistics for --stats: the solver counters summed over every solve,
+//# and wall and CPU time per pipeline phase. Work that the main thread fans
+//# out, e.g., a portfolio solve, is timed on the process CPU clock; work done
+//# entirely within one thread, e.g., a render, on that thread's. Phases that
+//# run on several threads at once, as in batch mode, add up the time of each
+//# thread. Safe to update from any thread.
+//##############################################################################
+
+#define PHASE_PARSE      0   // reading the config and generating the lattice
+#define PHASE_SETUP      1   // compatibility matrix and regions
+#define PHASE_SPRITES    2   // decoding sprite sheets and the background
+#define PHASE_SOLVE      3
+#define PHASE_COMPOSITE  4   // drawing tiles onto the canvas
+#define PHASE_ENCODE     5   // PNG encoding and writing
+#define PHASE_COUNT      6
+
+typedef struct {             // Start of a timed interval
+    clockid_t       cpu_clock;   // CLOCK_PROCESS_CPUTIME_ID or CLOCK_THREAD_CPUTIME_ID
+    struct timespec wall;
+    struct timespec cpu;
+} PhaseClock;
+
+typedef struct {
+    double          wall[PHASE_COUNT];   // seconds of wall time per phase
+    double          cpu[PHASE_COUNT];    // seconds of CPU time per phase
+    uint64_t        calls[PHASE_COUNT];  // timed intervals per phase
+    SolverStats     solver;              // counters of every solve so far
+    int             solves;              // number of solves added to solver
+    pthread_mutex_t lock;
+} RunStats;
+
+extern RunStats runstats;
+
+
+// Prototypes ==================================================================
+
+void runstats_solver(SolverStats *stats);
+void runstats_start(PhaseClock *clk, clockid_t cpu_clock);
+void runstats_stop(PhaseClock *clk, int phase);
+bool runstats_write(char *fname);
+
+#endif // RUNSTATS_H
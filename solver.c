@@ -0,0 +1,1424 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "region.h"
+#include "rng.h"
+#include "solver.h"
+
+//##############################################################################
+//# Domain maintenance, AC-3 style constraint propagation and backtracking
+//# search. The compat rows turn each revision into a handful of bitset
+//# operations: the tiles that may sit in direction d of vertex v are the union
+//# of compat_row(t, d) over every t still in v's domain, and the neighbor's
+//# domain is intersected with that.
+//#
+//# Above level 0 every changed domain word is logged on the trail along with
+//# its cause, either the vertex whose propagation changed it or the decision
+//# or refutation that did. On a wipeout, analyze_conflict() walks the trail
+//# back from the emptied domain to find the decision levels that actually
+//# contributed, and the search refutes the most recent of those, skipping any
+//# later levels that had nothing to do with the conflict.
+//#
+//# The decisions of the contributing levels also form a nogood, which is kept
+//# in a cache that outlives backjumps and restarts. Whenever a vertex is
+//# narrowed to a single tile, the nogoods it completes are looked up, so a
+//# combination that failed before is cut off without searching below it again.
+//#
+//# Searches that restart also keep a conflict score per vertex, and the MRV
+//# heuristic breaks ties by it, so that the vertices behind earlier failures
+//# are decided early after the next restart. Remaining ties are broken by a
+//# random order that changes with every restart.
+//#
+//# With a step budget or a deadline, the search also keeps the consistent
+//# state in which it had the most vertices narrowed to a single tile, so that
+//# running out of budget still leaves a partial assignment to show for it.
+//##############################################################################
+
+
+//==============================================================================
+// Allocates solver state for region opt->region of config.vert and the compat
+// matrix, and sets up the initial domains: the vertex's eligible tiles (or all
+// of them) that compat_prune() left, less any tile that lacks an endcap facing
+// a missing neighbor. A side facing a NEIGHBOR_OPEN vertex is left
+// unconstrained. Vertices are renumbered 0..nverts-1 within the region. A
+// neighbor in another region is either fixed, in which case the domain is
+// narrowed to the tiles that fit its one tile, or the vertex itself is fixed
+// and the neighbor checks the pair from its side. region_build() must have
+// been called. Every vertex starts out queued, so the first solver_propagate()
+// establishes arc consistency over the whole lattice, and tile-count limits
+// are enforced along with it. Returns false if some domain is empty before
+// propagation even starts.
+//==============================================================================
+
+bool solver_init(Solver *sv, SolverOptions *opt) {
+    OrderKey *keys;
+    uint64_t *dom;
+    int32_t  *nbr;
+    int       v, d, i, u;
+
+    memset(sv, 0, sizeof(Solver));
+    sv->opt = *opt;
+    sv->restart_limit = opt->restart_base;
+    sv->bump   = 1.0;
+    sv->result = SOLVE_PAUSED;
+    nogood_init(&sv->nogoods, opt->nogoods);
+
+    sv->nverts = regions.start[opt->region + 1] - regions.start[opt->region];
+    sv->vert   = regions.vert + regions.start[opt->region];
+    sv->ndirs  = compat.ndirs;
+    sv->ntiles = compat.ntiles;
+    sv->words  = compat.words;
+
+    switch(sv->ndirs) {
+        case 4:
+            sv->propagate = sv->words == 1 ? propagate_word4 : propagate_vertex4;
+            break;
+        case 6:
+            sv->propagate = sv->words == 1 ? propagate_word6 : propagate_vertex6;
+            break;
+        case 8:
+            sv->propagate = sv->words == 1 ? propagate_word8 : propagate_vertex8;
+            break;
+        default:
+            sv->propagate = propagate_vertex;
+            break;
+    }
+
+    sv->dom     = calloc((size_t)sv->nverts * sv->words, sizeof(uint64_t));
+    sv->size    = calloc(sv->nverts, sizeof(int));
+    sv->weight  = calloc(sv->nverts, sizeof(double));
+    sv->wlogw   = calloc(sv->nverts, sizeof(double));
+    sv->alias   = calloc(sv->nverts, sizeof(AliasTable));
+    sv->nbr     = malloc(sizeof(int) * (size_t)sv->nverts * sv->ndirs);
+    sv->queue   = malloc(sizeof(int) * sv->nverts);
+    sv->queued  = calloc(sv->nverts, sizeof(bool));
+    sv->support = malloc(sizeof(uint64_t) * sv->ndirs * sv->words);
+    sv->order   = malloc(sizeof(int) * sv->nverts);
+    keys        = malloc(sizeof(OrderKey) * sv->nverts);
+
+    sv->trail_size   = 1024;
+    sv->trail        = malloc(sizeof(TrailEntry) * sv->trail_size);
+    sv->reasons_size = 256;
+    sv->reasons      = malloc(sizeof(int) * sv->reasons_size);
+    sv->levels       = calloc(sv->nverts + 1, sizeof(Level));
+    sv->mark         = calloc(sv->nverts, sizeof(int));
+    sv->level_mark   = calloc(sv->nverts + 1, sizeof(int));
+    sv->held         = malloc(sizeof(int) * sv->nverts);
+    sv->attempts     = calloc(sv->nverts, sizeof(uint32_t));
+    sv->best_tile    = malloc(sizeof(int) * sv->nverts);
+    sv->score        = calloc(sv->nverts, sizeof(double));
+
+    if(!sv->dom || !sv->size || !sv->weight || !sv->wlogw || !sv->alias || !sv->nbr || !sv->queue || !sv->queued || !sv->support
+            || !sv->order || !keys || !sv->trail || !sv->reasons || !sv->levels
+            || !sv->mark || !sv->level_mark || !sv->held || !sv->attempts || !sv->best_tile || !sv->score) {
+        printf("Unable to allocate solver state.\n");
+        abort();
+    }
+    if(sv->opt.select == SELECT_MRV && !bucketq_create(&sv->mrv, sv->nverts, sv->ntiles + 1)) {
+        printf("Unable to allocate MRV queue.\n");
+        abort();
+    }
+
+    for(v = 0; v < sv->nverts; v++) {
+        nbr = vertex_neighbors(&config.vert, sv->vert[v]);
+        dom = solver_dom(sv, v);
+        solver_root(sv, v, dom);
+
+        for(d = 1; d <= sv->ndirs; d++) {
+            u = nbr[d - 1];
+            sv->nbr[(size_t)v * sv->ndirs + d - 1] = u >= 0 && regions.id[u] == opt->region ? regions.local[u] : -1;
+        }
+
+        sv->size[v] = bitset_count(dom, sv->words);
+        for(i = 0; i < sv->words; i++)
+            solver_reweigh(sv, v, i, dom[i], 1.0);
+        if(!sv->size[v]) {
+            fprintf(stderr, "Vertex %d has no eligible tile that fits its borders and fixed neighbors.\n", sv->vert[v]);
+            free(keys);
+            return false;
+        }
+        if(sv->opt.select == SELECT_MRV && sv->size[v] > 1)
+            bucketq_update(&sv->mrv, v, sv->size[v]);
+        if(sv->size[v] == 1)
+            sv->assigned++;
+        sv->best_tile[v] = -1;
+        sv->held[v]      = -1;
+
+        solver_enqueue(sv, v);
+
+        keys[v].order = config.vert.order[sv->vert[v]];
+        keys[v].index = v;
+    }
+
+    qsort(keys, sv->nverts, sizeof(OrderKey), compare_order);
+    for(v = 0; v < sv->nverts; v++)
+        sv->order[v] = keys[v].index;
+    free(keys);
+
+    solver_tally(sv);
+
+    return true;
+}
+
+
+//==============================================================================
+// Writes the initial domain of vertex v to dom, as described at solver_init(),
+// before any propagation. Every tile v can take in a solution is in it.
+//==============================================================================
+
+void solver_root(Solver *sv, int v, uint64_t *dom) {
+    int32_t *nbr;
+    int     *elig;
+    int      i, d, u, t, n;
+
+    nbr  = vertex_neighbors(&config.vert, sv->vert[v]);
+    elig = vertex_eligible(&config.vert, sv->vert[v], &n);
+
+    if(n) {
+        memset(dom, 0, sizeof(uint64_t) * sv->words);
+        for(i = 0; i < n; i++)
+            bitset_set(dom, elig[i]);
+    } else {
+        bitset_fill(dom, sv->ntiles);
+    }
+    bitset_and(dom, compat.live, sv->words);
+
+    for(d = 1; d <= sv->ndirs; d++) {
+        u = nbr[d - 1];
+        if(u == NEIGHBOR_OPEN)
+            continue;
+        if(u < 0)
+            bitset_and(dom, compat_border(d), sv->words);
+        else if(regions.id[u] != sv->opt.region && (t = region_fixed(u)) >= 0 && get_opposite_dir(d))
+            bitset_and(dom, compat_row(t, get_opposite_dir(d)), sv->words);
+    }
+}
+
+
+//==============================================================================
+// Adds the counters in stats to sum. The peak trail is the largest of the two.
+//==============================================================================
+
+void solver_add_stats(SolverStats *sum, SolverStats *stats) {
+    sum->propagations   += stats->propagations;
+    sum->revisions      += stats->revisions;
+    sum->pruned         += stats->pruned;
+    sum->wipeouts       += stats->wipeouts;
+    sum->decisions      += stats->decisions;
+    sum->backtracks     += stats->backtracks;
+    sum->backjumps      += stats->backjumps;
+    sum->levels_skipped += stats->levels_skipped;
+    sum->restarts       += stats->restarts;
+    sum->learned        += stats->learned;
+    sum->nogood_prunes  += stats->nogood_prunes;
+    if(stats->peak_trail > sum->peak_trail)
+        sum->peak_trail = stats->peak_trail;
+}
+
+
+//==============================================================================
+// qsort comparator for OrderKey, ordering by Vertices.order and then by index
+// so that ties are stable.
+//==============================================================================
+
+int compare_order(const void *a, const void *b) {
+    const OrderKey *ka = a;
+    const OrderKey *kb = b;
+
+    if(ka->order != kb->order)
+        return ka->order < kb->order ? -1 : 1;
+    return ka->index - kb->index;
+}
+
+
+//==============================================================================
+// Releases the solver's storage.
+//==============================================================================
+
+void solver_free(Solver *sv) {
+    int v;
+
+    if(sv->alias)
+        for(v = 0; v < sv->nverts; v++)
+            alias_free(sv->alias + v);
+    free(sv->dom);
+    free(sv->size);
+    free(sv->weight);
+    free(sv->wlogw);
+    free(sv->alias);
+    free(sv->nbr);
+    free(sv->queue);
+    free(sv->queued);
+    free(sv->support);
+    free(sv->order);
+    free(sv->trail);
+    free(sv->reasons);
+    free(sv->levels);
+    free(sv->mark);
+    free(sv->level_mark);
+    free(sv->held);
+    free(sv->attempts);
+    free(sv->best_tile);
+    free(sv->score);
+    if(sv->opt.select == SELECT_MRV)
+        bucketq_free(&sv->mrv);
+    nogood_free(&sv->nogoods);
+    count_state_free(&sv->limits);
+    memset(sv, 0, sizeof(Solver));
+}
+
+
+//==============================================================================
+// Adds vertex v to the propagation queue unless it is already there.
+//==============================================================================
+
+void solver_enqueue(Solver *sv, int v) {
+    if(sv->queued[v])
+        return;
+    sv->queued[v] = true;
+    sv->queue[(sv->qhead + sv->qcnt) % sv->nverts] = v;
+    sv->qcnt++;
+}
+
+
+//==============================================================================
+// Empties the propagation queue and the tile-count groups pending
+// enforcement.
+//==============================================================================
+
+void solver_flush(Solver *sv) {
+    CountState *cs = &sv->limits;
+
+    while(sv->qcnt) {
+        sv->queued[sv->queue[sv->qhead]] = false;
+        sv->qhead = (sv->qhead + 1) % sv->nverts;
+        sv->qcnt--;
+    }
+    while(cs->npending)
+        cs->queued[cs->pending[--cs->npending]] = false;
+}
+
+
+//==============================================================================
+// Appends an undo record to the trail, growing it as needed.
+//==============================================================================
+
+void trail_push(Solver *sv, int v, int word, uint64_t old, int cause) {
+    TrailEntry *e;
+
+    if(sv->trail_len == sv->trail_size) {
+        sv->trail_size *= 2;
+        sv->trail = realloc(sv->trail, sizeof(TrailEntry) * sv->trail_size);
+        if(!sv->trail) {
+            printf("Unable to grow solver trail.\n");
+            abort();
+        }
+    }
+
+    e = sv->trail + sv->trail_len++;
+    e->vertex = v;
+    e->word   = word;
+    e->old    = old;
+    e->cause  = cause;
+
+    if(sv->trail_len > sv->stats.peak_trail)
+        sv->stats.peak_trail = sv->trail_len;
+}
+
+
+//==============================================================================
+// Intersects the domain of vertex v with mask. If anything was removed, v is
+// queued for propagation, the tile-count counters follow, and, above level 0,
+// the old words are logged on the trail with the supplied cause. Returns false
+// if the domain was wiped out, in which case sv->conflict is set to v.
+//==============================================================================
+
+bool solver_restrict(Solver *sv, int v, const uint64_t *mask, int cause) {
+    uint64_t *dom = solver_dom(sv, v);
+    uint64_t  old;
+    int       i, removed = 0;
+
+    if(bitset_subset(dom, mask, sv->words))
+        return true;
+    if(counts.nlimits)
+        memcpy(sv->limits.old, dom, sizeof(uint64_t) * sv->words);
+
+    for(i = 0; i < sv->words; i++) {
+        old = dom[i];
+        if(old & ~mask[i]) {
+            if(sv->level)
+                trail_push(sv, v, i, old, cause);
+            solver_reweigh(sv, v, i, old & ~mask[i], -1.0);
+            dom[i] = old & mask[i];
+            removed += __builtin_popcountll(old & ~mask[i]);
+        }
+    }
+
+    if(!removed)
+        return true;
+    if(counts.nlimits)
+        solver_recount(sv, v, sv->limits.old, true);
+
+    sv->size[v] -= removed;
+    sv->stats.pruned += removed;
+    if(sv->size[v] == 1)
+        sv->assigned++;
+    else if(!sv->size[v] && removed == 1)
+        sv->assigned--;
+    if(!sv->size[v]) {
+        sv->stats.wipeouts++;
+        sv->conflict = v;
+        return false;
+    }
+
+    if(sv->opt.select == SELECT_MRV) {
+        if(sv->size[v] > 1)
+            bucketq_update(&sv->mrv, v, sv->size[v]);
+        else
+            bucketq_remove(&sv->mrv, v);
+    }
+
+    solver_enqueue(sv, v);
+    return true;
+}
+
+
+//==============================================================================
+// Opens a new decision level, fixes vertex v to tile and propagates the
+// consequences. Returns false on a contradiction.
+//==============================================================================
+
+bool solver_decide(Solver *sv, int v, int tile) {
+    uint64_t *mask = sv->support;
+    Level    *lvl;
+
+    lvl = sv->levels + ++sv->level;
+    lvl->trail   = sv->trail_len;
+    lvl->reasons = sv->reasons_len;
+    lvl->cursor  = sv->cursor;
+    lvl->vertex  = v;
+    lvl->tile    = tile;
+
+    sv->stats.decisions++;
+
+    memset(mask, 0, sizeof(uint64_t) * sv->words);
+    bitset_set(mask, tile);
+
+    if(!solver_restrict(sv, v, mask, CAUSE_DECISION))
+        return false;
+    return solver_propagate(sv);
+}
+
+
+//==============================================================================
+// Removes tile from vertex v at the current level and propagates. reason is
+// the offset in sv->reasons of the decision levels that justify the removal,
+// which conflict analysis picks up if the removal later contributes to
+// another conflict. Returns false on a contradiction.
+//==============================================================================
+
+bool solver_refute(Solver *sv, int v, int tile, int reason) {
+    uint64_t *mask = sv->support;
+
+    bitset_fill(mask, sv->ntiles);
+    bitset_clear(mask, tile);
+
+    if(!solver_restrict(sv, v, mask, CAUSE_REFUTED - reason))
+        return false;
+    return solver_propagate(sv);
+}
+
+
+//==============================================================================
+// Backtracks to the given decision level, restoring every domain word logged
+// above it along with the tile-count counters, and discarding any pending
+// propagation.
+//==============================================================================
+
+void solver_undo(Solver *sv, int level) {
+    TrailEntry *e;
+    uint64_t   *dom;
+    Level      *lvl = sv->levels + level + 1;
+    int         size;
+
+    while(sv->trail_len > lvl->trail) {
+        e    = sv->trail + --sv->trail_len;
+        dom  = solver_dom(sv, e->vertex);
+        size = sv->size[e->vertex];
+
+        sv->size[e->vertex] += __builtin_popcountll(e->old) - __builtin_popcountll(dom[e->word]);
+        sv->assigned += (sv->size[e->vertex] == 1) - (size == 1);
+        solver_reweigh(sv, e->vertex, e->word, e->old & ~dom[e->word], 1.0);
+        if(counts.nlimits)
+            memcpy(sv->limits.old, dom, sizeof(uint64_t) * sv->words);
+        dom[e->word] = e->old;
+        if(counts.nlimits)
+            solver_recount(sv, e->vertex, sv->limits.old, false);
+
+        if(sv->opt.select == SELECT_MRV && sv->size[e->vertex] > 1)
+            bucketq_update(&sv->mrv, e->vertex, sv->size[e->vertex]);
+    }
+
+    solver_flush(sv);
+
+    sv->reasons_len = lvl->reasons;
+    sv->cursor      = lvl->cursor;
+    sv->level       = level;
+}
+
+
+//==============================================================================
+// Determines which decision levels contributed to the wipeout of
+// sv->conflict. The trail is scanned from newest to oldest: a marked vertex
+// marks the cause of each of its logged changes in turn, decisions contribute
+// their own level, and refutations contribute the levels of their reasons,
+// or, for a nogood's, mark the vertices whose tiles completed it.
+// Since causes always precede their effects on the trail, one pass yields the
+// transitive closure. A decision entry unmarks its vertex, since the domain it
+// left behind does not depend on anything earlier; older changes that relied
+// on the vertex will mark it again.
+//
+// On return, the contributing levels are stamped in sv->level_mark with
+// sv->stamp. Returns the highest such level, or 0 if the conflict follows from
+// the root alone.
+//==============================================================================
+
+int analyze_conflict(Solver *sv) {
+    TrailEntry *e;
+    int         i, j, cnt, r, lvl, max = 0;
+
+    sv->stamp++;
+    sv->mark[sv->conflict] = sv->stamp;
+    lvl = sv->level;
+
+    for(i = sv->trail_len - 1; i >= 0; i--) {
+        while(i < sv->levels[lvl].trail)
+            lvl--;
+
+        e = sv->trail + i;
+        if(sv->mark[e->vertex] != sv->stamp)
+            continue;
+
+        if(e->cause >= 0) {
+            sv->mark[e->cause] = sv->stamp;
+        } else if(e->cause == CAUSE_DECISION) {
+            sv->level_mark[lvl] = sv->stamp;
+            sv->mark[e->vertex] = 0;
+            if(lvl > max)
+                max = lvl;
+        } else {
+            r   = CAUSE_REFUTED - e->cause;
+            cnt = sv->reasons[r];
+            if(cnt & REASON_VERTICES) {
+                for(j = 1; j <= (cnt & ~REASON_VERTICES); j++)
+                    sv->mark[sv->reasons[r + j]] = sv->stamp;
+                continue;
+            }
+            for(j = 1; j <= cnt; j++) {
+                sv->level_mark[sv->reasons[r + j]] = sv->stamp;
+                if(sv->reasons[r + j] > max)
+                    max = sv->reasons[r + j];
+            }
+        }
+    }
+
+    return max;
+}
+
+
+//==============================================================================
+// Runs the search to completion. See solver_run().
+//==============================================================================
+
+int solver_search(Solver *sv) {
+    return solver_run(sv, 0);
+}
+
+
+//==============================================================================
+// Runs the search for up to steps decisions and backtracks, or to completion
+// if steps is 0. Returns SOLVE_OK if every vertex has been narrowed to a
+// single tile, which solver_tile() then reports, SOLVE_UNSAT, SOLVE_CANCELLED
+// if another thread raised the cancel flag, or SOLVE_PAUSED if the steps ran
+// out, in which case calling solver_run() again carries on where it stopped.
+// Once the search has finished, further calls return the same verdict.
+//
+// Decisions take the tile chosen by solver_pick(). On a contradiction the
+// search jumps back to the highest contributing level J, undoes it, and
+// refutes decision J there with the remaining contributing levels as the
+// reason. If that refutation fails in turn, the process repeats. With
+// restarts enabled, the search returns to level 0 whenever restart_limit
+// backtracks have accumulated. The learned nogoods and conflict scores stay,
+// and the next limit follows opt.restart; either way the limits grow without
+// bound, so the search remains complete.
+//
+// Once the step budget or the deadline in the options runs out, the search
+// returns SOLVE_BUDGET instead, with the best partial assignment it came
+// across in sv->best_tile. It is not final: with a larger budget, calling
+// solver_run() again carries on.
+//==============================================================================
+
+int solver_run(Solver *sv, uint64_t steps) {
+    Level   *lvl;
+    uint64_t start = sv->stats.decisions + sv->stats.backtracks, iter = 0;
+    bool     ok;
+    int      v, j, i, r, cnt, top;
+
+    if(sv->result != SOLVE_PAUSED)
+        return sv->result;
+
+    if(!sv->started) {
+        sv->started = true;
+        if(!solver_propagate(sv))
+            return sv->result = SOLVE_UNSAT;
+    }
+
+    for(;;) {
+        if(sv->opt.cancel && __atomic_load_n(sv->opt.cancel, __ATOMIC_RELAXED))
+            return SOLVE_CANCELLED;
+        if(steps && sv->stats.decisions + sv->stats.backtracks - start >= steps)
+            return SOLVE_PAUSED;
+        if(solver_exhausted(sv, iter++)) {
+            solver_record(sv, sv->assigned, sv->trail_len);
+            return SOLVE_BUDGET;
+        }
+
+        if(sv->restart_limit && sv->restart_count >= sv->restart_limit) {
+            solver_undo(sv, 0);
+            sv->restart_count = 0;
+            sv->stats.restarts++;
+            if(sv->opt.restart == RESTART_LUBY)
+                sv->restart_limit = sv->opt.restart_base * solver_luby(sv->stats.restarts + 1);
+            else
+                sv->restart_limit *= 2;
+        }
+
+        v = solver_select(sv);
+        if(v < 0)
+            return sv->result = SOLVE_OK;
+
+        // Every state reached here is consistent, and the one just before a
+        // decision fails has the most vertices assigned on its branch.
+
+        top = sv->assigned;
+        ok  = solver_decide(sv, v, solver_pick(sv, v));
+        if(!ok)
+            solver_record(sv, top, sv->levels[sv->level].trail);
+
+        while(!ok) {
+            j = analyze_conflict(sv);
+            if(!j)
+                return sv->result = SOLVE_UNSAT;
+
+            sv->stats.backtracks++;
+            sv->restart_count++;
+            if(j < sv->level) {
+                sv->stats.backjumps++;
+                sv->stats.levels_skipped += sv->level - j;
+            }
+
+            solver_learn(sv, j);
+            if(sv->opt.restart_base)
+                solver_bump(sv, j);
+
+            lvl = sv->levels + j;
+            v   = lvl->vertex;
+            solver_undo(sv, j - 1);
+
+            // Store the reason, i.e., the contributing levels other than j.
+            // The stamps survive solver_undo(), which only touches domains.
+
+            cnt = 0;
+            for(i = 1; i < j; i++)
+                if(sv->level_mark[i] == sv->stamp)
+                    cnt++;
+            r = solver_reason(sv, cnt);
+            for(i = 1, cnt = 1; i < j; i++)
+                if(sv->level_mark[i] == sv->stamp)
+                    sv->reasons[r + cnt++] = i;
+
+            ok = solver_refute(sv, v, lvl->tile, r);
+        }
+    }
+}
+
+
+//==============================================================================
+// Returns the monotonic clock in seconds, the time base of
+// SolverOptions.deadline.
+//==============================================================================
+
+double solver_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+//==============================================================================
+// Returns true if the step budget has been used up, or if the deadline has
+// passed. iter counts the calls within one solver_run(); since reading the
+// clock costs more than a search step, the deadline is only checked every
+// SOLVER_CLOCK_STEPS calls, starting with the first.
+//==============================================================================
+
+bool solver_exhausted(Solver *sv, uint64_t iter) {
+    if(sv->opt.step_budget && sv->stats.decisions + sv->stats.backtracks >= sv->opt.step_budget)
+        return true;
+    return sv->opt.deadline && !(iter % SOLVER_CLOCK_STEPS) && solver_clock() >= sv->opt.deadline;
+}
+
+
+//==============================================================================
+// Keeps the state the search was in when the trail held trail entries and
+// assigned vertices had a single tile as the best partial assignment, if
+// there is a budget and no earlier state had as many. The domains are rolled
+// back to that point by swapping each newer trail entry with the word it
+// logged, newest first, and then swapped forward again in the opposite order.
+//==============================================================================
+
+void solver_record(Solver *sv, int assigned, int trail) {
+    TrailEntry *e;
+    uint64_t   *dom, word;
+    int         v, i;
+
+    if(!sv->opt.step_budget && !sv->opt.deadline)
+        return;
+    if(assigned <= sv->best)
+        return;
+    sv->best = assigned;
+
+    for(v = 0; v < sv->nverts; v++)
+        sv->best_tile[v] = solver_tile(sv, v);
+
+    for(i = sv->trail_len - 1; i >= trail; i--) {
+        e    = sv->trail + i;
+        dom  = solver_dom(sv, e->vertex);
+        word = dom[e->word];
+        dom[e->word] = e->old;
+        e->old = word;
+    }
+    for(i = trail; i < sv->trail_len; i++) {
+        v   = sv->trail[i].vertex;
+        dom = solver_dom(sv, v);
+        sv->best_tile[v] = bitset_count(dom, sv->words) == 1 ? bitset_first(dom, sv->words) : -1;
+    }
+    for(i = trail; i < sv->trail_len; i++) {
+        e    = sv->trail + i;
+        dom  = solver_dom(sv, e->vertex);
+        word = dom[e->word];
+        dom[e->word] = e->old;
+        e->old = word;
+    }
+}
+
+
+//==============================================================================
+// Adds the decisions of the levels up to j that analyze_conflict() stamped as
+// contributing to the conflict to the nogood cache. The nogood is minimized
+// first: a decision is dropped if the decisions left in it already force its
+// vertex to its tile, i.e., if no other tile of the vertex's initial domain
+// fits the tiles held by its neighbors in the nogood. Whatever still fits the
+// smaller nogood would have been excluded by the larger one anyway, so it
+// remains sound, and it cuts off more of the search. Nogoods left with more
+// than NOGOOD_MAX_LITS decisions are not kept.
+//==============================================================================
+
+void solver_learn(Solver *sv, int j) {
+    int       vertex[NOGOOD_MAX_LITS], tile[NOGOOD_MAX_LITS];
+    uint64_t *dom = sv->support;
+    int      *nbr;
+    int       i, v, u, d, opp, n = 0;
+
+    if(!sv->nogoods.capacity)
+        return;
+
+    for(i = 1; i <= j; i++) {
+        if(sv->level_mark[i] != sv->stamp)
+            continue;
+        sv->held[sv->levels[i].vertex] = sv->levels[i].tile;
+        n++;
+    }
+
+    // Drop the implied decisions, always keeping at least one.
+
+    for(i = j; i > 0 && n > 1; i--) {
+        if(sv->level_mark[i] != sv->stamp)
+            continue;
+        v   = sv->levels[i].vertex;
+        nbr = sv->nbr + (size_t)v * sv->ndirs;
+        solver_root(sv, v, dom);
+        for(d = 1; d <= sv->ndirs; d++) {
+            u   = nbr[d - 1];
+            opp = get_opposite_dir(d);
+            if(u >= 0 && sv->held[u] >= 0 && opp)
+                bitset_and(dom, compat_row(sv->held[u], opp), sv->words);
+        }
+        bitset_clear(dom, sv->levels[i].tile);
+        if(bitset_empty(dom, sv->words)) {
+            sv->held[v] = -1;
+            n--;
+        }
+    }
+
+    n = 0;
+    for(i = 1; i <= j; i++) {
+        v = sv->levels[i].vertex;
+        if(sv->level_mark[i] != sv->stamp || sv->held[v] < 0)
+            continue;
+        if(n < NOGOOD_MAX_LITS) {
+            vertex[n] = v;
+            tile[n]   = sv->held[v];
+        }
+        sv->held[v] = -1;
+        n++;
+    }
+
+    if(n <= NOGOOD_MAX_LITS && nogood_add(&sv->nogoods, n, vertex, tile))
+        sv->stats.learned++;
+}
+
+
+//==============================================================================
+// Raises the conflict scores of the vertices that analyze_conflict() blamed
+// for the last conflict: the one that was wiped out and the decision vertices
+// of the contributing levels up to j. Rather than fading every score after
+// each conflict, the increment grows, and once it gets large, every score and
+// the increment are scaled back down together.
+//==============================================================================
+
+void solver_bump(Solver *sv, int j) {
+    int i, v;
+
+    sv->score[sv->conflict] += sv->bump;
+    for(i = 1; i <= j; i++)
+        if(sv->level_mark[i] == sv->stamp)
+            sv->score[sv->levels[i].vertex] += sv->bump;
+
+    sv->bump /= SOLVER_SCORE_DECAY;
+    if(sv->bump > 1e100) {
+        for(v = 0; v < sv->nverts; v++)
+            sv->score[v] *= 1e-100;
+        sv->bump *= 1e-100;
+    }
+}
+
+
+//==============================================================================
+// Returns the i'th term of the Luby sequence, counting from 1: 1, 1, 2, 1, 1,
+// 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ... Term 2^k - 1 is 2^(k-1), and the terms
+// in between repeat the sequence from its start.
+//==============================================================================
+
+uint64_t solver_luby(uint64_t i) {
+    int k;
+
+    for(;;) {
+        for(k = 1; ((uint64_t)1 << k) - 1 < i; k++)
+            ;
+        if(((uint64_t)1 << k) - 1 == i)
+            return (uint64_t)1 << (k - 1);
+        i -= ((uint64_t)1 << (k - 1)) - 1;
+    }
+}
+
+
+//==============================================================================
+// Checks the cached nogoods that contain vertex v, which holds a single tile.
+// A nogood whose other literals all hold as well is violated, so v loses its
+// tile. One whose literals all hold except for a single vertex that still has
+// a choice is unit: that vertex loses the literal's tile. Either removal
+// records the vertices of the other literals as its reason. Returns false on
+// a domain wipeout.
+//==============================================================================
+
+bool solver_nogoods(Solver *sv, int v) {
+    NogoodCache *nc = &sv->nogoods;
+    int          t = bitset_first(solver_dom(sv, v), sv->words);
+    int          occ, base, n, k, u, target, r, cnt;
+
+    for(occ = nogood_first(nc, v, t); occ >= 0; occ = nogood_next(nc, nc->lit_next[occ], v, t)) {
+        n      = occ / NOGOOD_MAX_LITS;
+        base   = n * NOGOOD_MAX_LITS;
+        target = -1;
+
+        for(k = 0; k < nc->nlits[n]; k++) {
+            u = nc->vertex[base + k];
+            if(!bitset_test(solver_dom(sv, u), nc->tile[base + k]))
+                break;
+            if(sv->size[u] > 1) {
+                if(target >= 0)
+                    break;
+                target = base + k;
+            }
+        }
+        if(k < nc->nlits[n])
+            continue;
+        if(target < 0)
+            target = occ;
+
+        r = solver_reason(sv, nc->nlits[n] - 1);
+        sv->reasons[r] |= REASON_VERTICES;
+        for(k = 0, cnt = 1; k < nc->nlits[n]; k++)
+            if(base + k != target)
+                sv->reasons[r + cnt++] = nc->vertex[base + k];
+
+        nogood_touch(nc, n);
+        sv->stats.nogood_prunes++;
+
+        bitset_fill(sv->support, sv->ntiles);
+        bitset_clear(sv->support, nc->tile[target]);
+        if(!solver_restrict(sv, nc->vertex[target], sv->support, CAUSE_REFUTED - r))
+            return false;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// Sets up the tile-count counters of every group from the initial domains and
+// from the vertices outside the region: one fixed to a tile counts as holding
+// it, and a free one as possibly holding any of its eligible tiles. Groups
+// that are already at a limit are queued for solver_limit().
+//==============================================================================
+
+void solver_tally(Solver *sv) {
+    CountState *cs = &sv->limits;
+    CountLimit *cl;
+    uint64_t   *dom;
+    int        *elig;
+    int         v, g, i, t, n;
+
+    count_state_init(cs);
+    if(!counts.nlimits)
+        return;
+
+    for(v = 0; v < sv->nverts; v++) {
+        dom = solver_dom(sv, v);
+        for(g = 0; g < counts.nlimits; g++) {
+            cs->must[g] += count_within(dom, g, sv->words);
+            cs->may[g]  += count_meets(dom, g);
+        }
+    }
+
+    for(v = 0; v < config.vert.used; v++) {
+        if(regions.id[v] == sv->opt.region)
+            continue;
+        if((t = region_fixed(v)) >= 0) {
+            if((g = counts.group[t]) >= 0) {
+                cs->must[g]++;
+                cs->may[g]++;
+            }
+            continue;
+        }
+
+        elig = vertex_eligible(&config.vert, v, &n);
+        for(g = 0; g < counts.nlimits; g++) {
+            cl = counts.limit + g;
+            for(i = 0; i < n && (elig[i] < cl->first || elig[i] >= cl->last); i++)
+                ;
+            if(!n || i < n)
+                cs->may[g]++;
+        }
+    }
+
+    for(g = 0; g < counts.nlimits; g++) {
+        cl = counts.limit + g;
+        if((cs->must[g] >= cl->max && cs->may[g] > cl->max) || (cs->may[g] <= cl->min && cs->must[g] < cl->min)) {
+            cs->queued[g] = true;
+            cs->pending[cs->npending++] = g;
+        }
+    }
+}
+
+
+//==============================================================================
+// Updates the counters of the group of tile t, if it has one that has not been
+// updated yet during the current solver_recount(), for a domain that changed
+// from before to dom. See there.
+//==============================================================================
+
+static void recount_group(Solver *sv, const uint64_t *before, const uint64_t *dom, int t, bool tighten) {
+    CountState *cs = &sv->limits;
+    CountLimit *cl;
+    int         g;
+
+    if(t < 0 || (g = counts.group[t]) < 0 || cs->seen[g] == cs->stamp)
+        return;
+    cs->seen[g] = cs->stamp;
+    cl = counts.limit + g;
+
+    cs->must[g] += count_within(dom, g, sv->words) - count_within(before, g, sv->words);
+    cs->may[g]  += count_meets(dom, g) - count_meets(before, g);
+
+    if(tighten && !cs->queued[g]
+            && ((cs->must[g] >= cl->max && cs->may[g] > cl->max) || (cs->may[g] <= cl->min && cs->must[g] < cl->min))) {
+        cs->queued[g] = true;
+        cs->pending[cs->npending++] = g;
+    }
+}
+
+
+//==============================================================================
+// Updates the tile-count counters after the domain of vertex v changed from
+// before to its current contents. Only the groups of the tiles that changed
+// can gain or lose v as a possible holder, and only the groups of the first
+// tile before and after can gain or lose it as a certain one. If tighten is
+// set, i.e., the domain shrank, a group that now has as many certain holders
+// as its maximum while others remain possible, or as few possible holders as
+// its minimum while some are not certain, is queued for solver_limit().
+//==============================================================================
+
+void solver_recount(Solver *sv, int v, const uint64_t *before, bool tighten) {
+    uint64_t *dom = solver_dom(sv, v), bits;
+    int       i;
+
+    sv->limits.stamp++;
+    recount_group(sv, before, dom, bitset_first(before, sv->words), tighten);
+    recount_group(sv, before, dom, bitset_first(dom, sv->words), tighten);
+    for(i = 0; i < sv->words; i++)
+        for(bits = before[i] ^ dom[i]; bits; bits &= bits - 1)
+            recount_group(sv, before, dom, (i << 6) + __builtin_ctzll(bits), tighten);
+}
+
+
+//==============================================================================
+// Returns true if vertex v belongs to the reason for enforcing the limit of
+// group g: with over set, if it is certain to hold the group, and otherwise
+// if it can no longer hold it.
+//==============================================================================
+
+static bool limit_reason(Solver *sv, int g, int v, bool over) {
+    uint64_t *dom = solver_dom(sv, v);
+
+    return over ? count_within(dom, g, sv->words) : !count_meets(dom, g);
+}
+
+
+//==============================================================================
+// Enforces the limit of tile-count group g, which solver_recount() or
+// solver_tally() found to be tight, unless it has eased since. With as many
+// vertices certain to hold the group as its maximum, every other vertex loses
+// the group's tiles. With as few vertices that may hold it as its minimum,
+// each of them is narrowed to the group's tiles. The reason lists the
+// vertices that are certain to hold the group, or those that can no longer
+// hold it, respectively. Past either limit, a vertex is wiped out: one that
+// holds the group for the maximum, or one that may still hold it for the
+// minimum. If no vertex may hold the group at all, the first one is wiped out
+// instead. Either way the wiped out vertex is left out of the reason, since
+// conflict analysis follows its own changes anyway. Returns false on the
+// wipeout.
+//==============================================================================
+
+bool solver_limit(Solver *sv, int g) {
+    CountState *cs   = &sv->limits;
+    CountLimit *cl   = counts.limit + g;
+    uint64_t   *mask = sv->support, *dom;
+    int         v, i, r = 0, cnt = 0, target = -1;
+    bool        over, conflict;
+
+    over = cs->must[g] >= cl->max && cs->may[g] > cl->max;
+    if(!over && !(cs->may[g] <= cl->min && cs->must[g] < cl->min))
+        return true;
+    conflict = cs->must[g] > cl->max || cs->may[g] < cl->min;
+
+    for(v = 0; v < sv->nverts; v++) {
+        if(limit_reason(sv, g, v, over))
+            cnt++;
+        if(conflict && count_meets(solver_dom(sv, v), g) && (!over || limit_reason(sv, g, v, true)))
+            target = v;
+    }
+
+    if(conflict && target < 0)
+        target = 0;
+
+    if(sv->level) {
+        cnt -= conflict && limit_reason(sv, g, target, over);
+        r = solver_reason(sv, cnt);
+        sv->reasons[r] |= REASON_VERTICES;
+        for(v = 0, i = 1; i <= cnt; v++)
+            if(v != target && limit_reason(sv, g, v, over))
+                sv->reasons[r + i++] = v;
+    }
+
+    if(conflict) {
+        memset(mask, 0, sizeof(uint64_t) * sv->words);
+        return solver_restrict(sv, target, mask, CAUSE_REFUTED - r);
+    }
+
+    if(over) {
+        bitset_fill(mask, sv->ntiles);
+        bitset_andnot(mask, cl->set, sv->words);
+    } else {
+        memcpy(mask, cl->set, sizeof(uint64_t) * sv->words);
+    }
+    for(v = 0; v < sv->nverts; v++) {
+        dom = solver_dom(sv, v);
+        if(count_meets(dom, g) && !count_within(dom, g, sv->words) && !solver_restrict(sv, v, mask, CAUSE_REFUTED - r))
+            return false;
+    }
+    return true;
+}
+
+
+//==============================================================================
+// Returns a tile of a group that is still short of its minimum for vertex v to
+// try first, or -1 to leave the choice to solver_pick(). Each group that v may
+// hold and that lacks k certain holders gets picked with probability k over
+// the number of undecided vertices, which spreads the tiles that are needed
+// over the whole search instead of leaving them to be forced in at its end.
+// The tile is the group's lowest one in the domain, or a random one if
+// opt.random_values is set. Draws are keyed like those of solver_pick().
+//==============================================================================
+
+int solver_needed(Solver *sv, int v) {
+    CountState *cs  = &sv->limits;
+    CountLimit *cl;
+    uint64_t   *dom = solver_dom(sv, v);
+    int         g, t, k, open = sv->nverts - sv->assigned;
+
+    for(g = 0; g < counts.nlimits; g++) {
+        cl = counts.limit + g;
+        if(cs->must[g] >= cl->min || !count_meets(dom, g))
+            continue;
+        if(rng_double(sv->opt.seed, sv->vert[v], sv->attempts[v]++) * open >= cl->min - cs->must[g])
+            continue;
+
+        for(t = cl->first, k = 0; t < cl->last; t++)
+            k += bitset_test(dom, t);
+        if(sv->opt.random_values)
+            k = rng_u64(sv->opt.seed, sv->vert[v], sv->attempts[v]++) % k;
+        else
+            k = 0;
+        for(t = cl->first; !bitset_test(dom, t) || k--; t++)
+            ;
+        return t;
+    }
+
+    return -1;
+}
+
+
+//==============================================================================
+// Chooses the tile to try first at vertex v: the lowest one in its domain, or
+// a random one weighted by Tile.weight if opt.random_values is set. Random
+// draws are keyed by the seed, the vertex and the number of earlier draws at
+// that vertex, so they do not depend on what happened elsewhere in the
+// lattice.
+//
+// Sampling uses an alias table over a superset of the domain and rejects
+// tiles that are no longer in it. Every vertex starts out with the table over
+// all tiles in compat; once the domain holds less than ALIAS_MIN_FILL of its
+// table's weight, or has regained tiles the table lacks after a backtrack, it
+// gets a table of its own built from the current domain. That keeps the
+// expected number of draws below 1 / ALIAS_MIN_FILL without an O(k) scan per
+// decision. Tile-count minimums take precedence, see solver_needed().
+//==============================================================================
+
+int solver_pick(Solver *sv, int v) {
+    uint64_t   *dom = solver_dom(sv, v);
+    AliasTable *at;
+    int         t;
+
+    if(counts.nlimits && (t = solver_needed(sv, v)) >= 0)
+        return t;
+    if(!sv->opt.random_values)
+        return bitset_first(dom, sv->words);
+
+    at = sv->alias[v].n ? sv->alias + v : &compat.alias;
+    if(sv->weight[v] < at->weight * ALIAS_MIN_FILL || !bitset_subset(dom, at->set, sv->words)) {
+        at = sv->alias + v;
+        alias_build(at, dom, sv->words, compat.weight);
+    }
+
+    do {
+        t = alias_sample(at, rng_u64(sv->opt.seed, sv->vert[v], sv->attempts[v]++));
+    } while(!bitset_test(dom, t));
+
+    return t;
+}
+
+
+//==============================================================================
+// Appends a reason with room for cnt entries to sv->reasons, growing it as
+// needed, and returns its offset. The count is filled in; the entries are
+// left to the caller.
+//==============================================================================
+
+int solver_reason(Solver *sv, int cnt) {
+    int r = sv->reasons_len;
+
+    if(r + cnt + 1 > sv->reasons_size) {
+        while(r + cnt + 1 > sv->reasons_size)
+            sv->reasons_size *= 2;
+        sv->reasons = realloc(sv->reasons, sizeof(int) * sv->reasons_size);
+        if(!sv->reasons) {
+            printf("Unable to grow solver reasons.\n");
+            abort();
+        }
+    }
+
+    sv->reasons[r] = cnt;
+    sv->reasons_len += cnt + 1;
+    return r;
+}
+
+
+//==============================================================================
+// Adds (sign 1.0) or subtracts (sign -1.0) the weights of the tiles in bits,
+// which is word word of a domain, to or from the running totals of vertex v.
+//==============================================================================
+
+void solver_reweigh(Solver *sv, int v, int word, uint64_t bits, double sign) {
+    int t;
+
+    for(; bits; bits &= bits - 1) {
+        t = (word << 6) + __builtin_ctzll(bits);
+        sv->weight[v] += sign * compat.weight[t];
+        sv->wlogw[v]  += sign * compat.wlogw[t];
+    }
+}
+
+
+//==============================================================================
+// Returns the tile of a decided vertex, or -1 if its domain still holds more
+// than one tile.
+//==============================================================================
+
+int solver_tile(Solver *sv, int v) {
+    if(sv->size[v] != 1)
+        return -1;
+    return bitset_first(solver_dom(sv, v), sv->words);
+}
+
+
+//==============================================================================
+// Revises every neighbor of v against v's current domain, for a direction
+// count known to the caller. Since the compat rows of a tile are stored side
+// by side for all its directions, the supports of every direction are
+// gathered at once with one bitset_or() of ndirs rows per tile in the domain.
+// Inlined into the specialised propagate_vertex*() below with a constant
+// ndirs, which lets the compiler unroll the direction loop and fold the
+// strides. Returns false if a neighbor's domain is wiped out.
+//==============================================================================
+
+static inline __attribute__((always_inline)) bool propagate_dirs(Solver *sv, int v, int ndirs) {
+    uint64_t *dom   = solver_dom(sv, v);
+    int      *nbr   = sv->nbr + (size_t)v * ndirs;
+    int       words = sv->words;
+    int       block = ndirs * words;
+    int       d, t;
+
+    sv->stats.propagations++;
+
+    memset(sv->support, 0, sizeof(uint64_t) * block);
+    for(t = bitset_first(dom, words); t >= 0; t = bitset_next(dom, words, t + 1))
+        bitset_or(sv->support, compat.rows + (size_t)t * block, block);
+
+    for(d = 0; d < ndirs; d++) {
+        if(nbr[d] < 0)
+            continue;
+
+        sv->stats.revisions++;
+        if(!solver_restrict(sv, nbr[d], sv->support + (size_t)d * words, v))
+            return false;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// propagate_dirs() for domains of a single word, which covers tile sets of up
+// to 64 tiles. The supports are gathered in a local array that the compiler
+// can keep in registers, one row word per direction and tile, with no calls
+// to the bitset kernels. Only inlined with a constant ndirs of at most 8.
+//==============================================================================
+
+static inline __attribute__((always_inline)) bool propagate_word(Solver *sv, int v, int ndirs) {
+    uint64_t  support[8] = { 0 };
+    uint64_t  bits = *solver_dom(sv, v);
+    uint64_t *row;
+    int      *nbr  = sv->nbr + (size_t)v * ndirs;
+    int       d;
+
+    sv->stats.propagations++;
+
+    for(; bits; bits &= bits - 1) {
+        row = compat.rows + (size_t)__builtin_ctzll(bits) * ndirs;
+        for(d = 0; d < ndirs; d++)
+            support[d] |= row[d];
+    }
+
+    for(d = 0; d < ndirs; d++) {
+        if(nbr[d] < 0)
+            continue;
+
+        sv->stats.revisions++;
+        if(!solver_restrict(sv, nbr[d], support + d, v))
+            return false;
+    }
+
+    return true;
+}
+
+
+//==============================================================================
+// propagate_dirs() for any direction count, and specialised for the counts of
+// the square, hex and octagonal lattices, both for any domain size and, with
+// propagate_word(), for domains of a single word. solver_init() picks one.
+//==============================================================================
+
+bool propagate_vertex(Solver *sv, int v) {
+    return propagate_dirs(sv, v, sv->ndirs);
+}
+
+bool propagate_vertex4(Solver *sv, int v) {
+    return propagate_dirs(sv, v, 4);
+}
+
+bool propagate_vertex6(Solver *sv, int v) {
+    return propagate_dirs(sv, v, 6);
+}
+
+bool propagate_vertex8(Solver *sv, int v) {
+    return propagate_dirs(sv, v, 8);
+}
+
+bool propagate_word4(Solver *sv, int v) {
+    return propagate_word(sv, v, 4);
+}
+
+bool propagate_word6(Solver *sv, int v) {
+    return propagate_word(sv, v, 6);
+}
+
+bool propagate_word8(Solver *sv, int v) {
+    return propagate_word(sv, v, 8);
+}
+
+
+//==============================================================================
+// Drains the propagation queue, checking the cached nogoods of each vertex
+// that has been narrowed to a single tile on the way. Whenever the queue runs
+// dry, the next tile-count group that has reached a limit is enforced, which
+// may queue more vertices. Returns false on a domain wipeout, in which case
+// both queues are emptied and the domains are left in their failed state.
+//==============================================================================
+
+bool solver_propagate(Solver *sv) {
+    CountState *cs = &sv->limits;
+    int         v, g;
+
+    for(;;) {
+        while(sv->qcnt) {
+            v = sv->queue[sv->qhead];
+            sv->qhead = (sv->qhead + 1) % sv->nverts;
+            sv->qcnt--;
+            sv->queued[v] = false;
+
+            if((sv->size[v] == 1 && !solver_nogoods(sv, v)) || !sv->propagate(sv, v)) {
+                solver_flush(sv);
+                return false;
+            }
+        }
+
+        if(!cs->npending)
+            return true;
+        g = cs->pending[--cs->npending];
+        cs->queued[g] = false;
+        if(!solver_limit(sv, g)) {
+            solver_flush(sv);
+            return false;
+        }
+    }
+}
+
+
+//==============================================================================
+// Returns the next vertex to branch on, i.e., one whose domain still holds more
+// than one tile, or -1 if every vertex is decided. SELECT_ORDER walks the
+// vertices in Vertices.order. SELECT_MRV takes the smallest domain from the
+// bucket queue and breaks ties by lowest weighted entropy among the first
+// MRV_TIE_SCAN vertices in that bucket, which keeps selection independent of
+// the lattice size. Searches that restart break them by solver_prefer().
+//==============================================================================
+
+int solver_select(Solver *sv) {
+    double h, best_h;
+    int    v, best, k, i;
+
+    if(sv->opt.select == SELECT_ORDER) {
+        for(; sv->cursor < sv->nverts; sv->cursor++) {
+            if(sv->size[sv->order[sv->cursor]] > 1)
+                return sv->order[sv->cursor];
+        }
+        return -1;
+    }
+
+    k = bucketq_min(&sv->mrv);
+    if(k < 0)
+        return -1;
+
+    best   = sv->mrv.head[k];
+    best_h = vertex_entropy(sv, best);
+    for(v = sv->mrv.next[best], i = 1; v >= 0 && i < MRV_TIE_SCAN; v = sv->mrv.next[v], i++) {
+        h = vertex_entropy(sv, v);
+        if(sv->opt.restart_base ? solver_prefer(sv, v, h, best, best_h) : h < best_h) {
+            best   = v;
+            best_h = h;
+        }
+    }
+
+    return best;
+}
+
+
+//==============================================================================
+// Returns true if a search with restarts should rather branch on vertex a,
+// with entropy ha, than on vertex b, with entropy hb, when both have domains
+// of the same size: the higher conflict score wins, then the lower entropy,
+// and then a random order drawn afresh after every restart.
+//==============================================================================
+
+bool solver_prefer(Solver *sv, int a, double ha, int b, double hb) {
+    uint64_t seed;
+
+    if(sv->score[a] != sv->score[b])
+        return sv->score[a] > sv->score[b];
+    if(ha != hb)
+        return ha < hb;
+
+    seed = rng_u64(sv->opt.seed, SOLVER_RNG_STREAM, sv->stats.restarts);
+    return rng_u64(seed, sv->vert[a], 0) < rng_u64(seed, sv->vert[b], 0);
+}
+
+
+//==============================================================================
+// Returns the Shannon entropy of the tile weights remaining in v's domain,
+// i.e., log(W) - sum(w log w) / W where W is the total weight. Both sums are
+// kept up to date as the domain changes.
+//==============================================================================
+
+double vertex_entropy(Solver *sv, int v) {
+    return log(sv->weight[v]) - sv->wlogw[v] / sv->weight[v];
+}
+
+
+//==============================================================================
+// Prints the propagation counters to stdout.
+//==============================================================================
+
+void solver_print_stats(SolverStats *stats) {
+    printf("Decisions: %" PRIu64 ", backtracks: %" PRIu64 ", backjumps: %" PRIu64 " (%" PRIu64 " levels skipped), restarts: %" PRIu64 ", peak trail: %d\n",
+        stats->decisions, stats->backtracks, stats->backjumps, stats->levels_skipped,
+        stats->restarts, stats->peak_trail);
+    printf("Propagations: %" PRIu64 ", revisions: %" PRIu64 ", values pruned: %" PRIu64 ", wipeouts: %" PRIu64 "\n",
+        stats->propagations, stats->revisions, stats->pruned, stats->wipeouts);
+    printf("Nogoods learned: %" PRIu64 ", values pruned by nogoods: %" PRIu64 "\n",
+        stats->learned, stats->nogood_prunes);
+}
@@ -0,0 +1,203 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "alias.h"
+#include "bitset.h"
+#include "bucketq.h"
+#include "compat.h"
+#include "count.h"
+#include "nogood.h"
+#include "rng.h"
+#include "tilist.h"
+
+//##############################################################################
+//# Tile solver state. Each vertex carries a domain, the bitset of tiles that
+//# are still possible there. Domains are kept arc-consistent with the compat
+//# matrix by propagating along the neighbor graph, and the search branches on
+//# one vertex at a time, logging every domain change on a trail so that it can
+//# be undone without copying state per decision.
+//##############################################################################
+
+#define SELECT_ORDER 0           // branch on vertices in Vertices.order
+#define SELECT_MRV   1           // branch on the smallest domain, lowest entropy first
+
+#define MRV_TIE_SCAN 16          // max candidates examined for the entropy tie-break
+
+#define SOLVER_CLOCK_STEPS 1024  // search steps between checks of SolverOptions.deadline
+
+#define RESTART_GEOMETRIC 0      // SolverOptions.restart: the cutoff doubles after each restart
+#define RESTART_LUBY      1      // cutoffs follow the Luby sequence 1, 1, 2, 1, 1, 2, 4, ...
+
+#define SOLVER_RESTART_BASE 100  // default SolverOptions.restart_base for searches that restart
+#define SOLVER_SCORE_DECAY  0.95 // weight of a conflict score relative to the next conflict
+#define SOLVER_RNG_STREAM   (RNG_STREAM_BASE + 1) // rng.h stream for restart tie-breaking
+
+#define SOLVE_OK        0        // every vertex holds exactly one tile
+#define SOLVE_UNSAT     1        // the search space is exhausted
+#define SOLVE_CANCELLED 2        // *opt.cancel was set by another thread
+#define SOLVE_PAUSED    3        // the steps given to solver_run() ran out; the search can be resumed
+#define SOLVE_BUDGET    4        // SolverOptions.step_budget or deadline ran out, see solver_record()
+
+#define CAUSE_DECISION  -1       // TrailEntry.cause: the change is a branching decision
+#define CAUSE_REFUTED   -2       // TrailEntry.cause: refuted decision, nogood or count limit,
+                                 // reason at -(cause + 2) in reasons
+
+#define REASON_VERTICES (1 << 30) // flag on a reason's count: it lists vertices rather than levels
+
+typedef struct {             // Caller-supplied solver settings
+    int           select;        // SELECT_ORDER or SELECT_MRV
+    uint64_t      seed;          // seed for random value ordering, see rng.h
+    bool          random_values; // if true, decisions pick a random tile instead of the lowest
+    int           restart_base;  // if nonzero, backtracks before the first restart
+    int           restart;       // RESTART_*: how later cutoffs derive from restart_base
+    volatile int *cancel;        // if not NULL, the search gives up once *cancel is nonzero
+    int           region;        // region of the lattice to solve, see region.h
+    int           nogoods;       // capacity of the learned nogood cache, 0 to learn none
+    uint64_t      step_budget;   // if nonzero, search steps after which the search gives up
+    double        deadline;      // if nonzero, solver_clock() time at which the search gives up
+} SolverOptions;
+
+typedef struct {             // Sort key for visiting vertices in Vertices.order
+    int order;
+    int index;
+} OrderKey;
+
+typedef struct {             // Undo record for a single changed domain word
+    int      vertex;             // vertex whose domain changed
+    int      word;               // offset of the changed word within the domain
+    uint64_t old;                // previous contents of the word
+    int      cause;              // vertex whose propagation made the change, or CAUSE_*
+} TrailEntry;
+
+typedef struct {             // Bookkeeping for one decision level
+    int trail;                   // trail length when the level was entered
+    int reasons;                 // reasons length when the level was entered
+    int cursor;                  // SELECT_ORDER cursor when the level was entered
+    int vertex;                  // decision vertex
+    int tile;                    // tile the decision vertex was fixed to
+} Level;
+
+typedef struct {             // Counters reported after a run
+    uint64_t propagations;       // vertices dequeued and propagated to their neighbors
+    uint64_t revisions;          // neighbor domains intersected with a support row
+    uint64_t pruned;             // tile values removed from domains
+    uint64_t wipeouts;           // revisions that emptied a domain
+    uint64_t decisions;          // branching decisions
+    uint64_t backtracks;         // conflicts resolved by refuting a decision
+    uint64_t backjumps;          // backtracks that skipped at least one level
+    uint64_t levels_skipped;     // total levels skipped by backjumps
+    uint64_t restarts;           // restarts from level 0
+    uint64_t learned;            // nogoods added to the cache
+    uint64_t nogood_prunes;      // tile values removed by cached nogoods
+    int      peak_trail;         // high-water mark of the trail
+} SolverStats;
+
+typedef struct Solver {
+    SolverOptions opt;
+    int          nverts;         // number of vertices in the region
+    int         *vert;           // config.vert index of each vertex
+    int          ndirs;          // number of directions (config.dir.used - 1)
+    int          ntiles;         // number of tiles, i.e., bits per domain
+    int          words;          // uint64_t words per domain
+    uint64_t    *dom;            // nverts domains of words words each
+    int         *size;           // number of tiles left in each domain
+    double      *weight;         // total weight of the tiles left in each domain
+    double      *wlogw;          // sum of weight * log(weight) over the same tiles
+    AliasTable  *alias;          // per-vertex sampling tables, see solver_pick()
+    int         *nbr;            // nverts * ndirs neighbor indices, -1 for none
+    int         *queue;          // circular propagation queue of vertex indices
+    bool        *queued;         // true while the vertex is in the queue
+    int          qhead;          // next queue slot to pop
+    int          qcnt;           // number of vertices in the queue
+    uint64_t    *support;        // scratch rows, one per direction, for propagate_vertex()
+    bool       (*propagate)(struct Solver *sv, int v);  // propagate_vertex() specialised for ndirs and words
+    int         *order;          // vertex indices sorted by Vertices.order
+    int          cursor;         // SELECT_ORDER: no undecided vertex precedes order[cursor]
+    BucketQueue  mrv;            // SELECT_MRV: undecided vertices keyed by domain size
+    TrailEntry  *trail;          // undo log of domain changes above level 0
+    int          trail_len;
+    int          trail_size;
+    int         *reasons;        // refutation reasons: count followed by that many levels or vertices
+    int          reasons_len;
+    int          reasons_size;
+    Level       *levels;         // nverts + 1 decision levels, 0 being the root
+    int          level;          // current decision level
+    int          conflict;       // vertex whose domain was last wiped out
+    int         *mark;           // per-vertex stamps for conflict analysis
+    int         *level_mark;     // per-level stamps for conflict analysis
+    int          stamp;
+    int         *held;           // tile of each vertex in the nogood solver_learn() is minimizing, else -1
+    uint32_t    *attempts;       // decisions made so far at each vertex, keys random draws
+    int          assigned;       // vertices whose domain holds a single tile
+    int          best;           // most vertices assigned in any consistent state so far
+    int         *best_tile;      // tile of each vertex in that state, -1 where it was open
+    bool         started;        // the initial propagation has been done
+    int          result;         // final SOLVE_* verdict, SOLVE_PAUSED until there is one
+    uint64_t     restart_limit;  // backtracks allowed before the next restart
+    uint64_t     restart_count;  // backtracks since the last restart
+    double      *score;          // per-vertex conflict scores, kept across restarts
+    double       bump;           // current score increment, which grows to fade older conflicts
+    NogoodCache  nogoods;        // nogoods learned from earlier conflicts, kept across restarts
+    CountState   limits;         // tile-count counters, see count.h
+    SolverStats  stats;
+} Solver;
+
+
+//==============================================================================
+// Returns a pointer to the domain of vertex v.
+//==============================================================================
+
+static inline uint64_t *solver_dom(Solver *sv, int v) {
+    return sv->dom + (size_t)v * sv->words;
+}
+
+
+// Prototypes ==================================================================
+
+int  analyze_conflict(Solver *sv);
+int  compare_order(const void *a, const void *b);
+void solver_add_stats(SolverStats *sum, SolverStats *stats);
+double solver_clock(void);
+void solver_bump(Solver *sv, int level);
+bool solver_decide(Solver *sv, int v, int tile);
+void solver_enqueue(Solver *sv, int v);
+bool solver_exhausted(Solver *sv, uint64_t iter);
+void solver_flush(Solver *sv);
+void solver_free(Solver *sv);
+bool solver_init(Solver *sv, SolverOptions *opt);
+void solver_learn(Solver *sv, int level);
+bool solver_limit(Solver *sv, int g);
+uint64_t solver_luby(uint64_t i);
+int  solver_needed(Solver *sv, int v);
+bool solver_nogoods(Solver *sv, int v);
+int  solver_pick(Solver *sv, int v);
+bool solver_prefer(Solver *sv, int a, double ha, int b, double hb);
+bool solver_propagate(Solver *sv);
+void solver_print_stats(SolverStats *stats);
+int  solver_reason(Solver *sv, int cnt);
+void solver_recount(Solver *sv, int v, const uint64_t *before, bool tighten);
+void solver_record(Solver *sv, int assigned, int trail);
+bool solver_refute(Solver *sv, int v, int tile, int reason);
+bool solver_restrict(Solver *sv, int v, const uint64_t *mask, int cause);
+void solver_reweigh(Solver *sv, int v, int word, uint64_t bits, double sign);
+void solver_root(Solver *sv, int v, uint64_t *dom);
+int  solver_run(Solver *sv, uint64_t steps);
+int  solver_search(Solver *sv);
+int  solver_select(Solver *sv);
+void solver_tally(Solver *sv);
+int  solver_tile(Solver *sv, int v);
+void solver_undo(Solver *sv, int level);
+bool propagate_vertex(Solver *sv, int v);
+bool propagate_vertex4(Solver *sv, int v);
+bool propagate_vertex6(Solver *sv, int v);
+bool propagate_vertex8(Solver *sv, int v);
+bool propagate_word4(Solver *sv, int v);
+bool propagate_word6(Solver *sv, int v);
+bool propagate_word8(Solver *sv, int v);
+void trail_push(Solver *sv, int v, int word, uint64_t old, int cause);
+double vertex_entropy(Solver *sv, int v);
+
+#endif // SOLVER_H
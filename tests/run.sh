@@ -0,0 +1,206 @@
+#!/bin/sh
+#
+# Behavioural checks of tilist. Usage:
+#
+#     tests/run.sh [TILIST]
+#
+# TILIST is the binary to check, ./tilist by default. The configs in this
+# directory are small enough to solve in milliseconds; solutions that a config
+# forces are compared with the files in expected/, and everything else is
+# checked for the properties it must have, such as not depending on --threads.
+# unit.c is built with $CC (default: cc) from the sources in the parent
+# directory and run first. Prints one line per check and exits nonzero if any
+# of them failed.
+
+bin=${1:-./tilist}
+case $bin in
+    /*) ;;
+    *)  bin=$(pwd)/$bin ;;
+esac
+
+dir=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+cd "$dir" || exit 1
+
+failed=0
+
+# check NAME COMMAND...: runs COMMAND and reports NAME as passed if it succeeds.
+check() {
+    name=$1
+    shift
+    if "$@"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        failed=$((failed + 1))
+    fi
+}
+
+# solve ARGS...: runs tilist, keeping its output in $tmp/log.
+solve() {
+    "$bin" "$@" > "$tmp/log" 2>&1
+}
+
+# counter FILE NAME: prints the counter NAME from the --stats FILE.
+counter() {
+    sed -n "s/^[[:space:]]*\"$2\":[[:space:]]*\([0-9]*\),*$/\1/p" "$1" | head -n 1
+}
+
+# holding FILE TILE: prints how many vertices hold TILE in the solution FILE.
+holding() {
+    grep -c ":[[:space:]]*\"$2\"" "$1"
+}
+
+
+# Unit checks ------------------------------------------------------------------
+
+unit() {
+    ${CC:-cc} -std=gnu99 -O2 -o "$tmp/unit" unit.c ../alias.c ../bitset.c ../nogood.c -lm && "$tmp/unit"
+}
+check "unit: random streams, bitset kernels, alias sampling, nogood cache" unit
+
+
+# Lattices and propagation -----------------------------------------------------
+# Every vertex of a border lattice can only take the tile named after the set
+# of its sides that face a neighbor, so the solution spells out the neighbor
+# rules, and propagation alone must find it.
+
+lattice() {
+    solve border_$1.json --solution "$tmp/$1.json" --stats "$tmp/$1.stats" $2 \
+        && cmp -s "$tmp/$1.json" expected/border_$1.json \
+        && [ "$(counter "$tmp/$1.stats" backtracks)" = 0 ]
+}
+for kind in square hex triangular brick; do
+    check "lattice: $kind neighbors" lattice $kind
+done
+check "lattice: hex neighbors with MRV selection" lattice hex "--select mrv"
+check "lattice: square neighbors by local search" lattice square "--engine local"
+
+odd() {
+    solve odd.json --solution "$tmp/odd.json" && cmp -s "$tmp/odd.json" expected/odd.json
+}
+check "directions: an odd number of them" odd
+
+
+# Explicit vertices, regions and labels ----------------------------------------
+
+islands() {
+    solve islands.json --solution "$tmp/islands.json" --threads 2 && cmp -s "$tmp/islands.json" expected/islands.json
+}
+check "regions: two islands, a fixed vertex and matchLabels" islands
+
+resolve_same() {
+    solve islands.json --resolve expected/islands.json --solution "$tmp/same.json" \
+        && grep -q "Re-solved 0 of" "$tmp/log" \
+        && cmp -s "$tmp/same.json" expected/islands.json
+}
+check "resolve: an unchanged config keeps its solution" resolve_same
+
+resolve_edit() {
+    solve islands_edit.json --resolve expected/islands.json --solution "$tmp/edit.json" \
+        && cmp -s "$tmp/edit.json" expected/islands_edit.json
+}
+check "resolve: an edit only changes the vertices around it" resolve_edit
+
+
+# Search -----------------------------------------------------------------------
+# wang.json needs a thousand decisions or so, with backjumps and nogoods.
+
+solve wang.json --solution "$tmp/wang.json" --stats "$tmp/wang.stats"
+status=$?
+
+wang() {
+    [ $status = 0 ] && [ "$(grep -c ":" "$tmp/wang.json")" = 81 ]
+}
+check "search: wang tiles are solved" wang
+
+backjumps() {
+    [ "$(counter "$tmp/wang.stats" backjumps)" -gt 0 ] && [ "$(counter "$tmp/wang.stats" levelsSkipped)" -gt 0 ]
+}
+check "search: conflicts backjump over unrelated levels" backjumps
+
+nogoods() {
+    [ "$(counter "$tmp/wang.stats" learned)" -gt 0 ] \
+        && solve wang.json --nogoods 0 --stats "$tmp/off.stats" \
+        && [ "$(counter "$tmp/off.stats" learned)" = 0 ]
+}
+check "search: nogoods are learned, unless turned off" nogoods
+
+restarts() {
+    solve wang.json --restarts luby --restart-base 10 --stats "$tmp/luby.stats" \
+        && [ "$(counter "$tmp/luby.stats" restarts)" -gt 0 ]
+}
+check "search: Luby restarts" restarts
+
+stats() {
+    grep -q '"phases"' "$tmp/wang.stats" && grep -q '"solve"' "$tmp/wang.stats"
+}
+check "stats: solver counters and phase timings" stats
+
+threads() {
+    solve wang.json --portfolio 3 --threads 1 --solution "$tmp/t1.json" \
+        && solve wang.json --portfolio 3 --threads 3 --solution "$tmp/t3.json" \
+        && cmp -s "$tmp/t1.json" "$tmp/t3.json"
+}
+check "portfolio: the solution does not depend on --threads" threads
+
+budget() {
+    solve wang.json --step-budget 50 --solution "$tmp/part.json" \
+        && grep -q "Out of budget" "$tmp/log" \
+        && [ "$(grep -c ":" "$tmp/part.json")" = 81 ]
+}
+check "budget: running out leaves a filled in assignment" budget
+
+resume() {
+    solve wang.json --checkpoint "$tmp/ck" --step-budget 500 \
+        && [ -f "$tmp/ck" ] \
+        && solve wang.json --checkpoint "$tmp/ck" --resume --step-budget 100000 --solution "$tmp/resumed.json" \
+        && [ ! -f "$tmp/ck" ] \
+        && cmp -s "$tmp/resumed.json" "$tmp/wang.json"
+}
+check "checkpoint: resuming gives the same solution" resume
+
+
+# Tiles ------------------------------------------------------------------------
+
+counts() {
+    solve counts.json --solution "$tmp/counts.json" \
+        && [ "$(holding "$tmp/counts.json" few)" -le 3 ] \
+        && [ "$(holding "$tmp/counts.json" some)" -ge 20 ] \
+        && [ "$(holding "$tmp/counts.json" some)" -le 22 ] \
+        && [ "$(holding "$tmp/counts.json" rest)" -ge 9 ] \
+        && ! solve counts_unsat.json \
+        && grep -q "unsatisfiable" "$tmp/log"
+}
+check "counts: minCount and maxCount are honoured" counts
+
+rotate() {
+    solve rotate.json --stats "$tmp/rotate.stats" \
+        && [ "$(counter "$tmp/rotate.stats" tiles)" = 16 ] \
+        && grep -q "Pruned tile 'orphan'" "$tmp/log"
+}
+check "tiles: distinct orientations only, unusable tiles pruned" rotate
+
+
+# Output -----------------------------------------------------------------------
+
+batch() {
+    solve wang.json --count 3 --out "$tmp/a_%d.png" --threads 1 \
+        && solve wang.json --count 3 --out "$tmp/b_%d.png" --threads 3 \
+        && for k in 0 1 2; do cmp -s "$tmp/a_$k.png" "$tmp/b_$k.png" || return 1; done
+}
+check "batch: images do not depend on --threads" batch
+
+band() {
+    solve border_square.json --band 1 --out "$tmp/strip_%d.png" \
+        && [ "$(ls "$tmp" | grep -c "^strip_")" = 8 ]
+}
+check "band: strips cover the whole image" band
+
+
+if [ $failed -gt 0 ]; then
+    echo "$failed checks failed."
+    exit 1
+fi
+echo "All checks passed."
@@ -0,0 +1,204 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../alias.h"
+#include "../bitset.h"
+#include "../nogood.h"
+#include "../rng.h"
+
+//##############################################################################
+//# Unit checks of the self-contained modules: the seeded random streams, the
+//# bitset kernels against plain loops, alias table sampling against the tile
+//# weights, and the nogood cache. Built and run by run.sh; prints each failed
+//# check and exits nonzero if there is any.
+//##############################################################################
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+int failed;
+
+
+//==============================================================================
+// Reports the check on line unless cond holds.
+//==============================================================================
+
+void check(int cond, char *text, int line) {
+    if(cond)
+        return;
+    printf("unit.c:%d: check failed: %s\n", line, text);
+    failed++;
+}
+
+
+//==============================================================================
+// The same seed, stream and counter always give the same value, and changing
+// any of them gives another.
+//==============================================================================
+
+void test_rng(void) {
+    CHECK(rng_u64(1, 2, 3) == rng_u64(1, 2, 3));
+    CHECK(rng_u64(1, 2, 3) != rng_u64(1, 2, 4));
+    CHECK(rng_u64(1, 2, 3) != rng_u64(1, 3, 3));
+    CHECK(rng_u64(1, 2, 3) != rng_u64(2, 2, 3));
+    CHECK(rng_double(7, 0, 0) >= 0.0 && rng_double(7, 0, 0) < 1.0);
+}
+
+
+//==============================================================================
+// Every bitset operation, on lengths below and above BITSET_KERNEL_WORDS, must
+// agree with a plain loop over the words.
+//==============================================================================
+
+void test_bitset(void) {
+    uint64_t a[9], b[9], c[9], r;
+    int      words, i, k, n, cnt, first;
+    bool     sub, empty;
+
+    bitset_init();
+
+    for(k = 0; k < 200; k++) {
+        words = 1 + k % 9;
+        for(i = 0; i < words; i++) {
+            a[i] = rng_u64(k, 0, i) & rng_u64(k, 1, i);
+            b[i] = a[i] | rng_u64(k, 2, i);
+        }
+        if(k % 3 == 0)
+            memset(a, 0, sizeof(a));
+
+        cnt = 0;
+        first = -1;
+        sub = true;
+        empty = true;
+        for(i = 0; i < words * 64; i++) {
+            if(bitset_test(a, i)) {
+                cnt++;
+                empty = false;
+                if(first < 0)
+                    first = i;
+                if(!bitset_test(b, i))
+                    sub = false;
+            }
+        }
+        CHECK(bitset_count(a, words) == cnt);
+        CHECK(bitset_first(a, words) == first);
+        CHECK(bitset_empty(a, words) == empty);
+        CHECK(bitset_subset(a, b, words) == sub);
+        CHECK(!bitset_subset(b, a, words) || !memcmp(a, b, sizeof(uint64_t) * words));
+
+        for(n = 0, i = bitset_first(a, words); i >= 0; i = bitset_next(a, words, i + 1))
+            n++;
+        CHECK(n == cnt);
+
+        memcpy(c, a, sizeof(c));
+        bitset_or(c, b, words);
+        for(i = 0, r = 0; i < words; i++)
+            r |= c[i] ^ (a[i] | b[i]);
+        CHECK(!r);
+
+        memcpy(c, b, sizeof(c));
+        bitset_and(c, a, words);
+        for(i = 0, r = 0; i < words; i++)
+            r |= c[i] ^ (a[i] & b[i]);
+        CHECK(!r);
+
+        memcpy(c, b, sizeof(c));
+        bitset_andnot(c, a, words);
+        for(i = 0, r = 0; i < words; i++)
+            r |= c[i] ^ (b[i] & ~a[i]);
+        CHECK(!r);
+    }
+}
+
+
+//==============================================================================
+// Tiles drawn from an alias table come up in proportion to their weights, and
+// tiles outside its set never do.
+//==============================================================================
+
+void test_alias(void) {
+    AliasTable at;
+    uint64_t   set[2] = { 0 };
+    double     weight[70], freq[70] = { 0 }, sum = 0;
+    int        t, i, n = 400000;
+
+    for(t = 0; t < 70; t++)
+        weight[t] = 1 + t % 5;
+    for(t = 0; t < 70; t += 3) {
+        bitset_set(set, t);
+        sum += weight[t];
+    }
+
+    memset(&at, 0, sizeof(AliasTable));
+    alias_build(&at, set, 2, weight);
+    CHECK(at.n == 24);
+    CHECK(fabs(at.weight - sum) < 1e-9);
+
+    for(i = 0; i < n; i++)
+        freq[alias_sample(&at, rng_u64(5, 0, i))] += 1.0 / n;
+    for(t = 0; t < 70; t++) {
+        if(bitset_test(set, t))
+            CHECK(fabs(freq[t] - weight[t] / at.weight) < 0.005);
+        else
+            CHECK(freq[t] == 0);
+    }
+
+    alias_free(&at);
+}
+
+
+//==============================================================================
+// Nogoods are kept whatever the order of their literals, found through any of
+// their literals, and evicted least recently used first once the cache fills.
+//==============================================================================
+
+void test_nogood(void) {
+    NogoodCache nc;
+    int         v[NOGOOD_MAX_LITS + 1], t[NOGOOD_MAX_LITS + 1], i, occ;
+
+    nogood_init(&nc, 2);
+
+    v[0] = 7; t[0] = 1; v[1] = 3; t[1] = 2;
+    CHECK(nogood_add(&nc, 2, v, t));
+    CHECK(v[0] == 3 && t[0] == 2);
+    v[0] = 7; t[0] = 1; v[1] = 3; t[1] = 2;
+    CHECK(!nogood_add(&nc, 2, v, t));
+    CHECK(nc.used == 1);
+
+    occ = nogood_first(&nc, 7, 1);
+    CHECK(occ >= 0 && nc.nlits[occ / NOGOOD_MAX_LITS] == 2);
+    CHECK(nogood_first(&nc, 7, 2) < 0);
+
+    for(i = 0; i <= NOGOOD_MAX_LITS; i++) {
+        v[i] = i;
+        t[i] = 0;
+    }
+    CHECK(!nogood_add(&nc, NOGOOD_MAX_LITS + 1, v, t));
+
+    v[0] = 1; t[0] = 1;
+    CHECK(nogood_add(&nc, 1, v, t));
+    v[0] = 2; t[0] = 2;
+    CHECK(nogood_add(&nc, 1, v, t));
+    CHECK(nc.used == 2);
+    CHECK(nogood_first(&nc, 7, 1) < 0);
+    CHECK(nogood_first(&nc, 1, 1) >= 0 && nogood_first(&nc, 2, 2) >= 0);
+
+    nogood_free(&nc);
+}
+
+
+//==============================================================================
+// Runs every check. Returns nonzero if any of them failed.
+//==============================================================================
+
+int main(void) {
+    test_rng();
+    test_bitset();
+    test_alias();
+    test_nogood();
+
+    if(failed)
+        printf("%d unit checks failed.\n", failed);
+    return failed ? 1 : 0;
+}
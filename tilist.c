@@ -3,31 +3,422 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include "band.h"
+#include "batch.h"
+#include "checkpoint.h"
+#include "compat.h"
+#include "count.h"
 #include "dynarray.h"
+#include "label.h"
+#include "lattice.h"
+#include "local.h"
 #include "lodepng/lodepng.h"
+#include "orient.h"
+#include "region.h"
+#include "render.h"
+#include "resolve.h"
+#include "runstats.h"
+#include "solver.h"
 #include "tilist.h"
-#include "parsing.h"
 
 
 struct Config config;
 
 
 //==============================================================================
-// Main loop. The sole CLI argument is the filename of the config file.
+// Main loop. The CLI arguments are the filename of the config file and any
+// of the following options:
+//
+//     --select order|mrv    vertex selection heuristic (default: order)
+//     --portfolio K         race K differently configured solvers, the first
+//                           of which uses --select and --seed as given
+//                           (default: same as --threads, or 1 with --count)
+//     --threads N           number of threads to run them on (default: 1)
+//     --seed S              base seed for randomized solvers (default: 0)
+//     --nogoods N           conflicts each solver remembers, see nogood.h;
+//                           0 turns learning off (default: 4096)
+//     --restarts none|geometric|luby
+//                           restart policy of the first solver; the cutoff
+//                           doubles after each geometric restart and follows
+//                           the Luby sequence otherwise (default: none)
+//     --restart-base N      backtracks before the first restart (default: 100)
+//     --engine search|local search engine; 'local' repairs a random
+//                           assignment by min-conflicts moves instead, which
+//                           scales to far larger lattices but cannot prove a
+//                           config unsatisfiable; see local.h (default: search)
+//     --out FILE            write the rendered image to FILE
+//     --stats FILE          write the solver counters and the wall and CPU
+//                           time of each phase to FILE as JSON; see runstats.h
+//     --solution FILE       write the solution, i.e., each vertex's tile, to
+//                           FILE as JSON
+//     --resolve FILE        start from the solution in FILE, as written by
+//                           --solution for an earlier version of the config,
+//                           and re-solve only around the vertices whose tiles
+//                           no longer fit; if --out names the image rendered
+//                           from that solution, only the changes are redrawn
+//     --checkpoint FILE     save the state of the solve to FILE every few
+//                           minutes, and remove FILE once it is finished;
+//                           see checkpoint.h
+//     --checkpoint-interval SECONDS
+//                           time between checkpoints (default: 300)
+//     --resume              continue the solve saved in the --checkpoint FILE,
+//                           which must have been run with the same config and
+//                           the same --select, --seed, --nogoods, --restarts,
+//                           --restart-base and --portfolio
+//     --time-budget SECONDS give up on the search once SECONDS have passed
+//                           since the start of the run
+//     --step-budget STEPS   give up on the search of each region after STEPS
+//                           decisions and backtracks per solver, or, with
+//                           --engine local, after STEPS moves in total
+//
+// Before solving, tiles that no solution can use are pruned and reported:
+// tiles in no vertex's eligible list, and tiles with a side that is not an
+// endcap but mates none of the tiles left, until no more can be pruned. A
+// vertex left without an eligible tile fails the run right there.
+//
+// A search that runs out of budget keeps the partial assignment in which it
+// had the most vertices settled, and the remaining vertices get the tiles that
+// fit the most of their sides, endcaps facing open neighbors included. The
+// result is written and rendered like a solution. With --checkpoint, the state
+// file is kept, and --resume with a larger budget carries on from there; the
+// step budget counts the steps taken before the resume. Local search keeps its
+// final assignment, minus the vertices with mismatched edges, and gives up
+// after 1000 moves per vertex even without a budget.
+//
+// The solution depends only on the config, --select, --seed, --restarts,
+// --restart-base and --portfolio; changing --threads alone never changes the
+// output.
+//
+// Batch mode parses the config and loads the sprites once, then solves and
+// renders many variants, --threads at a time, each with a --portfolio of
+// solvers that gets any threads left over:
+//
+//     --count N             number of images to generate
+//     --seed-base S         seed of the first image; image k uses S + k
+//     --out PATTERN         printf-style filename with one integer conversion,
+//                           e.g., 'out_%05d.png', which receives k
+//
+// Band mode solves a config with a lattice entry a few rows at a time, keeping
+// memory proportional to the lattice width; see band.h:
+//
+//     --band ROWS           rows per band
+//     --lookahead ROWS      rows solved below each band and then discarded, to
+//                           keep it from ruling out the next (default: 2)
+//     --out PATTERN         as for batch mode; strip k of the image, one band
+//                           high, is written to the file PATTERN yields for k
 //==============================================================================
 
 int main(int argc, char **argv) {
-    bool bres;
+    SolverOptions opt = { SELECT_ORDER };
+    SolverStats   stats;
+    PhaseClock    clk;
+    uint64_t      moves;
+    char  *fname = NULL, *solution = NULL, *previous = NULL, *statsfile = NULL, *ckfile = NULL;
+    int   *tiles, *prev = NULL;
+    bool   bres, resume = false, local = false;
+    double interval = CHECKPOINT_INTERVAL, budget = 0, start = solver_clock();
+    int    i, res, area, filled, nthreads = 1, nworkers = 0, count = 0, lookahead = BAND_LOOKAHEAD;
+    int    restarts = -1, restart_base = SOLVER_RESTART_BASE;
+
+    opt.nogoods = NOGOOD_CACHE_SIZE;
+
+    for(i = 1; i < argc; i++) {
+        if(streq(argv[i], "--select") && i + 1 < argc) {
+            i++;
+            if(streq(argv[i], "order")) {
+                opt.select = SELECT_ORDER;
+            } else if(streq(argv[i], "mrv")) {
+                opt.select = SELECT_MRV;
+            } else {
+                printf("FATAL ERROR: --select must be 'order' or 'mrv'.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--threads") && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+            if(nthreads < 1) {
+                printf("FATAL ERROR: --threads must be a positive integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--portfolio") && i + 1 < argc) {
+            nworkers = atoi(argv[++i]);
+            if(nworkers < 1) {
+                printf("FATAL ERROR: --portfolio must be a positive integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--nogoods") && i + 1 < argc) {
+            opt.nogoods = atoi(argv[++i]);
+            if(opt.nogoods < 0) {
+                printf("FATAL ERROR: --nogoods must be a non-negative integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--restarts") && i + 1 < argc) {
+            i++;
+            if(streq(argv[i], "none")) {
+                restarts = -1;
+            } else if(streq(argv[i], "geometric")) {
+                restarts = RESTART_GEOMETRIC;
+            } else if(streq(argv[i], "luby")) {
+                restarts = RESTART_LUBY;
+            } else {
+                printf("FATAL ERROR: --restarts must be 'none', 'geometric' or 'luby'.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--restart-base") && i + 1 < argc) {
+            restart_base = atoi(argv[++i]);
+            if(restart_base < 1) {
+                printf("FATAL ERROR: --restart-base must be a positive integer.\n");
+                return 1;
+            }
+        } else if((streq(argv[i], "--seed") || streq(argv[i], "--seed-base")) && i + 1 < argc) {
+            opt.seed = strtoull(argv[++i], NULL, 0);
+        } else if(streq(argv[i], "--engine") && i + 1 < argc) {
+            i++;
+            if(streq(argv[i], "search")) {
+                local = false;
+            } else if(streq(argv[i], "local")) {
+                local = true;
+            } else {
+                printf("FATAL ERROR: --engine must be 'search' or 'local'.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--count") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+            if(count < 1) {
+                printf("FATAL ERROR: --count must be a positive integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--out") && i + 1 < argc) {
+            config.output_png_name = argv[++i];
+        } else if(streq(argv[i], "--band") && i + 1 < argc) {
+            config.band = atoi(argv[++i]);
+            if(config.band < 1) {
+                printf("FATAL ERROR: --band must be a positive integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--lookahead") && i + 1 < argc) {
+            lookahead = atoi(argv[++i]);
+            if(lookahead < 0) {
+                printf("FATAL ERROR: --lookahead must be a non-negative integer.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--solution") && i + 1 < argc) {
+            solution = argv[++i];
+        } else if(streq(argv[i], "--resolve") && i + 1 < argc) {
+            previous = argv[++i];
+        } else if(streq(argv[i], "--stats") && i + 1 < argc) {
+            statsfile = argv[++i];
+        } else if(streq(argv[i], "--checkpoint") && i + 1 < argc) {
+            ckfile = argv[++i];
+        } else if(streq(argv[i], "--checkpoint-interval") && i + 1 < argc) {
+            interval = atof(argv[++i]);
+            if(interval <= 0) {
+                printf("FATAL ERROR: --checkpoint-interval must be a positive number of seconds.\n");
+                return 1;
+            }
+        } else if(streq(argv[i], "--resume")) {
+            resume = true;
+        } else if(streq(argv[i], "--time-budget") && i + 1 < argc) {
+            budget = atof(argv[++i]);
+            if(budget <= 0) {
+                printf("FATAL ERROR: --time-budget must be a positive number of seconds.\n");
+                return 1;
+            }
+            opt.deadline = start + budget;
+        } else if(streq(argv[i], "--step-budget") && i + 1 < argc) {
+            opt.step_budget = strtoull(argv[++i], NULL, 0);
+            if(!opt.step_budget) {
+                printf("FATAL ERROR: --step-budget must be a positive integer.\n");
+                return 1;
+            }
+        } else if(argv[i][0] == '-') {
+            printf("FATAL ERROR: Unknown or incomplete option '%s'.\n", argv[i]);
+            return 1;
+        } else if(fname) {
+            printf("FATAL ERROR: Only one config file may be given.\n");
+            return 1;
+        } else {
+            fname = argv[i];
+        }
+    }
 
-    if(argc != 2) {
-        printf("FATAL ERROR: The config file must be the only command-line argument.\n");
+    if(!nworkers)
+        nworkers = count ? 1 : nthreads;
+    if(restarts >= 0) {
+        opt.restart      = restarts;
+        opt.restart_base = restart_base;
+    }
+
+    if(!fname) {
+        printf("FATAL ERROR: The config file must be given on the command line.\n");
+        return 1;
+    }
+    if(count && (!config.output_png_name || !batch_valid_pattern(config.output_png_name))) {
+        printf("FATAL ERROR: --count requires an --out pattern with exactly one integer conversion.\n");
+        return 1;
+    }
+    if(count && (solution || previous)) {
+        printf("FATAL ERROR: --solution and --resolve cannot be combined with --count.\n");
+        return 1;
+    }
+    if(config.band && (count || solution || previous)) {
+        printf("FATAL ERROR: --band cannot be combined with --count, --solution or --resolve.\n");
         return 1;
     }
+    if(config.band && (opt.deadline || opt.step_budget)) {
+        printf("FATAL ERROR: --band cannot be combined with --time-budget or --step-budget.\n");
+        return 1;
+    }
+    if(resume && !ckfile) {
+        printf("FATAL ERROR: --resume requires --checkpoint.\n");
+        return 1;
+    }
+    if(ckfile && (count || config.band || previous)) {
+        printf("FATAL ERROR: --checkpoint cannot be combined with --count, --band or --resolve.\n");
+        return 1;
+    }
+    if(local && (count || config.band || previous || ckfile)) {
+        printf("FATAL ERROR: --engine local cannot be combined with --count, --band, --resolve or --checkpoint.\n");
+        return 1;
+    }
+    if(config.band && config.output_png_name && !batch_valid_pattern(config.output_png_name)) {
+        printf("FATAL ERROR: --band requires an --out pattern with exactly one integer conversion.\n");
+        return 1;
+    }
+
+    config.threads = nthreads;
+    runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+    bres = init(fname);
+    runstats_stop(&clk, PHASE_PARSE);
+    if(!bres)
+        return 1;
 
-    bres = init(argv[1]);
+    runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+    bres = compat_build() && compat_prune();
+    runstats_stop(&clk, PHASE_SETUP);
     if(!bres)
         return 1;
 
+    if(config.band) {
+        for(i = 0; i < compat.ntiles; i++) {
+            if(((Tile *)config.tile.ary[i])->min_count >= 0 || ((Tile *)config.tile.ary[i])->max_count >= 0) {
+                printf("FATAL ERROR: --band cannot be combined with tile minCount or maxCount.\n");
+                return 1;
+            }
+        }
+        if(config.output_png_name) {
+            runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+            bres = render_sprites();
+            runstats_stop(&clk, PHASE_SPRITES);
+            if(!bres)
+                return 1;
+        }
+        bres = band_run(&opt, nworkers, nthreads, config.band, lookahead, config.output_png_name, &stats);
+        solver_print_stats(&stats);
+        if(statsfile && !runstats_write(statsfile))
+            return 1;
+        return bres ? 0 : 1;
+    }
+
+    runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+    bres = count_build() && region_build(NULL);
+    runstats_stop(&clk, PHASE_SETUP);
+    if(!bres)
+        return 1;
+    if(local && counts.nlimits) {
+        printf("FATAL ERROR: --engine local cannot be combined with tile minCount or maxCount.\n");
+        return 1;
+    }
+
+    if(config.output_png_name) {
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        bres = render_init();
+        runstats_stop(&clk, PHASE_SPRITES);
+        if(!bres)
+            return 1;
+    }
+
+    if(count) {
+        res = batch_run(&opt, nworkers, nthreads, count, config.output_png_name);
+        printf("Generated %d of %d images.\n", count - res, count);
+        if(statsfile && !runstats_write(statsfile))
+            return 1;
+        return res ? 1 : 0;
+    }
+
+    tiles = malloc(sizeof(int) * config.vert.used);
+    if(!tiles) {
+        printf("Unable to allocate tile assignment.\n");
+        abort();
+    }
+
+    if(previous) {
+        prev = malloc(sizeof(int) * config.vert.used);
+        if(!prev) {
+            printf("Unable to allocate tile assignment.\n");
+            abort();
+        }
+        bres = solution_read(previous, tiles);
+        if(!bres)
+            return 1;
+        memcpy(prev, tiles, sizeof(int) * config.vert.used);
+
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        res = resolve_solve(&opt, nworkers, nthreads, tiles, &stats, &area);
+        runstats_stop(&clk, PHASE_SOLVE);
+        printf("Re-solved %d of %d vertices.\n", area, config.vert.used);
+    } else if(local) {
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        res = local_solve(&opt, nthreads, tiles, &moves);
+        runstats_stop(&clk, PHASE_SOLVE);
+        printf("Moves: %" PRIu64 ", %.2f per vertex\n", moves, config.vert.used ? (double)moves / config.vert.used : 0.0);
+    } else {
+        if(ckfile && !checkpoint_open(ckfile, interval, resume, &opt, nworkers))
+            return 1;
+        runstats_start(&clk, CLOCK_PROCESS_CPUTIME_ID);
+        res = region_solve(&opt, nworkers, nthreads, tiles, &stats);
+        runstats_stop(&clk, PHASE_SOLVE);
+        if(res == SOLVE_BUDGET && ckfile && checkpoint_write())
+            printf("Search state saved to '%s'; run again with --resume and a larger budget to continue.\n", ckfile);
+        checkpoint_close(res != SOLVE_BUDGET);
+    }
+    if(!local) {
+        solver_print_stats(&stats);
+        runstats_solver(&stats);
+    }
+    if(res == SOLVE_BUDGET) {
+        filled = solution_fill(tiles);
+        printf("Out of budget: %d of %d vertices solved, the rest filled with the best fitting tiles.\n",
+            config.vert.used - filled, config.vert.used);
+    } else if(res != SOLVE_OK) {
+        printf("FATAL ERROR: The config is unsatisfiable.\n");
+        if(statsfile)
+            runstats_write(statsfile);
+        return 1;
+    }
+
+    memcpy(config.vert.tile, tiles, sizeof(int) * config.vert.used);
+    for(i = 0; i < config.vert.used; i++)
+        config.vert.orientation[i] = tiles[i] < 0 ? 0 : ((Tile *)config.tile.ary[tiles[i]])->orientation;
+
+    if(solution) {
+        bres = solution_write(solution, tiles);
+        if(!bres)
+            return 1;
+    }
+
+    if(config.output_png_name) {
+        if(prev)
+            bres = render_patch(config.output_png_name, prev, tiles);
+        else
+            bres = render_write(config.output_png_name, tiles);
+        if(!bres)
+            return 1;
+    }
+    free(tiles);
+    free(prev);
+
+    if(statsfile && !runstats_write(statsfile))
+        return 1;
 
     return 0;
 }
@@ -37,7 +428,7 @@ int main(int argc, char **argv) {
 // Initial setup of data structures.
 //==============================================================================
 
-int init(char *fname) {
+bool init(char *fname) {
     bool result;
 
     config.dir.nmemb = 32;
@@ -45,11 +436,6 @@ int init(char *fname) {
         printf("Unable to initialize config.dir.\n");
         abort();
     }
-    config.vert.nmemb = 256;
-    if(!dynarray_create(&config.vert)) {
-        printf("Unable to initialize config.vert.\n");
-        abort();
-    }
     config.tile.nmemb = 256;
     if(!dynarray_create(&config.tile)) {
         printf("Unable to initialize config.tile.\n");
@@ -58,7 +444,7 @@ int init(char *fname) {
 
     result = parse_config(fname);
 
-    return 0;
+    return result;
 }
 
 /*
@@ -92,6 +478,12 @@ int init(char *fname) {
             tileWidth:  20,
             centerX:    10,
             centerY:    10,
+            weight:     2.5,     // relative frequency, defaults to 1
+            minCount:   2,       // fewest vertices that must hold the tile, in
+            maxCount:   "5%",    // any orientation, and most that may; a number
+                                 // or a percentage of all vertices, see count.h
+            rotate:     true,    // also place the tile rotated; see orient.h
+            mirror:     false,   // also place the tile mirrored
         },
         pinky: { },
         inky:  { },
@@ -101,7 +493,8 @@ int init(char *fname) {
     vertices: {
         foo: {
             order: 1,
-            eligibleTiles: [ "blinky", "pinky", "inky", "clyde" ],  // or null for all
+            eligibleTiles: [ "blinky", "pinky", "inky", "clyde" ],  // or null for all;
+                                                // "blinky@2": one orientation
             neighbors: {
                 N: "bar",
                 E: "baz",
@@ -113,6 +506,17 @@ int init(char *fname) {
         },
         ...
         },
+
+    // Instead of vertices, a lattice may be generated; see lattice.h.
+
+    lattice: {
+        type:     "hex",         // square, hex, triangular or brick
+        width:    1000,          // columns
+        height:   1000,          // rows
+        spacing:  20,            // or spacingX and spacingY
+        originX:  10,            // position of the first vertex, defaults to 0
+        originY:  10
+    }
 }
 
 
@@ -138,13 +542,14 @@ bool parse_config(char *fname) {
     if(!buf)
         return false;
 
-    json = cJSON_parse(buf);
+    json = cJSON_Parse(buf);
 
     if(json == NULL) {
         error_ptr = cJSON_GetErrorPtr();
         if(error_ptr != NULL) {
             fprintf(stderr, "Error in config file before: %s\n", error_ptr);
         }
+        free(buf);
         return false;
     }
     free(buf);
@@ -164,12 +569,12 @@ bool parse_config(char *fname) {
         fprintf(stderr, "Missing background.width entry in config file.\n");
         return false;
     }
-    if(!cJSON_isNumber(sub) || sub.valueint < 1) {
+    if(!cJSON_IsNumber(sub) || sub->valueint < 1) {
         fprintf(stderr, "Malformed background.width in config file, must be a positive integer.\n");
         return false;
     }
 
-    config.image_width = sub.valueint;
+    config.image_width = sub->valueint;
 
     // background.height -------------------------------------------------------
 
@@ -178,12 +583,12 @@ bool parse_config(char *fname) {
         fprintf(stderr, "Missing background.height entry in config file.\n");
         return false;
     }
-    if(!cJSON_isNumber(sub) || sub.valueint < 1) {
+    if(!cJSON_IsNumber(sub) || sub->valueint < 1) {
         fprintf(stderr, "Malformed background.height in config file, must be a positive integer.\n");
         return false;
     }
 
-    config.image_height = sub.valueint;
+    config.image_height = sub->valueint;
 
     // background.bgcolor ------------------------------------------------------
 
@@ -192,9 +597,9 @@ bool parse_config(char *fname) {
         fprintf(stderr, "Missing background.bgcolor entry in config file.\n");
         return false;
     }
-    if(strlen(sub.valuestring) == 7 && sub.valuestring[0] == '#') {
-        for(i = 1; i < 8; i++) {
-            if(!isxdigit(sub.valuestring[i])) {
+    if(cJSON_IsString(sub) && strlen(sub->valuestring) == 7 && sub->valuestring[0] == '#') {
+        for(i = 1; i < 7; i++) {
+            if(!isxdigit(sub->valuestring[i])) {
                 fprintf(stderr, "Malformed background.bgcolor entry, must be in the form '#xxxxxx', where 'x' represents a hexadecimal digit.\n");
                 return false;
             }
@@ -204,22 +609,25 @@ bool parse_config(char *fname) {
         return false;
     }
 
-    config.image.bgcolor.a = 0xFF;
-    parse_hex_triplet(sub.valuestring);
+    config.bgcolor.a = 0xFF;
+    parse_hex_triplet(sub->valuestring, &config.bgcolor);
 
     // background.image --------------------------------------------------------
 
     sub = cJSON_GetObjectItemCaseSensitive(cur, "image");
     if(sub != NULL) {
-        config.image.bg_image_filename = malloc(strlen(sub.valuestring) + 1);
-        strcpy(config.image.bg_image_filename, sub.valuestring);
+        if(!cJSON_IsString(sub)) {
+            fprintf(stderr, "Malformed background.image entry, must be a filename.\n");
+            return false;
+        }
+        config.bg_image_filename = copy_string(sub->valuestring);
     }
 
     // Parse and validate directions ===========================================
 
-    cur = cJSON_GetObjectItemCaseSensitive(json, "background");
+    cur = cJSON_GetObjectItemCaseSensitive(json, "directions");
     if(cur == NULL) {
-        fprintf(stderr, "Missing background entry in config file.\n");
+        fprintf(stderr, "Missing directions entry in config file.\n");
         return false;
     }
     if(!cJSON_IsArray(cur)) {
@@ -235,22 +643,25 @@ bool parse_config(char *fname) {
 
     // Load directions into Config struct --------------------------------------
 
-    dynarray_push(Config.dir, NULL);  // empty placeholder value for 0
+    dynarray_push(&config.dir, NULL);  // empty placeholder value for 0
 
     for(i = 0; i < cnt; i++) {
         sub = cJSON_GetArrayItem(cur, i);
-        newstr = malloc(strlen(sub.valuestring + 1));
-        strcpy(newstr, sub.valuestring);
-        dynarray_push(Config.dir, newstr);
+        if(!cJSON_IsString(sub)) {
+            fprintf(stderr, "The directions array must contain only strings.\n");
+            return false;
+        }
+        newstr = copy_string(sub->valuestring);
+        dynarray_push(&config.dir, newstr);
     }
 
     // Check for duplicates ----------------------------------------------------
 
     for(i = 1; i < cnt; i++) {
-        for(j = i + 1; j <= cnt; i++) {
-            if(streqn(Config.dir.ary[i], Config.dir.ary[j])) {
+        for(j = i + 1; j <= cnt; j++) {
+            if(streq(config.dir.ary[i], config.dir.ary[j])) {
                 fprintf(stderr, "Duplicate directions '%s' and '%s' in config file.\n",
-                    Config.dir.ary[i], Config.dir.ary[j]);
+                    (char *)config.dir.ary[i], (char *)config.dir.ary[j]);
                 return false;
             }
         }
@@ -258,8 +669,568 @@ bool parse_config(char *fname) {
 
     // Parse and validate tiles ================================================
 
-    // Parse and validate vertices =============================================
+    cur = cJSON_GetObjectItemCaseSensitive(json, "tiles");
+    if(cur == NULL) {
+        fprintf(stderr, "Missing tiles entry in config file.\n");
+        return false;
+    }
+    if(!cJSON_IsObject(cur)) {
+        fprintf(stderr, "The tiles element in the config file must be an object.\n");
+        return false;
+    }
+
+    cJSON_ArrayForEach(sub, cur) {
+        if(!parse_tile(sub))
+            return false;
+    }
+
+    if(!config.tile.used) {
+        fprintf(stderr, "The tiles object must define at least one tile.\n");
+        return false;
+    }
+    label_intern();
+
+    // Parse and validate vertices, or generate them from the lattice ==========
 
+    cur = cJSON_GetObjectItemCaseSensitive(json, "lattice");
+    sub = cJSON_GetObjectItemCaseSensitive(json, "vertices");
+    if(cur != NULL && sub != NULL) {
+        fprintf(stderr, "The config file may have a lattice or a vertices entry, but not both.\n");
+        return false;
+    }
+    if(cur != NULL) {
+        if(!parse_lattice(cur))
+            return false;
+        cJSON_Delete(json);
+        return true;
+    }
+
+    cur = sub;
+    if(cur == NULL) {
+        fprintf(stderr, "Missing vertices or lattice entry in config file.\n");
+        return false;
+    }
+    if(!cJSON_IsObject(cur)) {
+        fprintf(stderr, "The vertices element in the config file must be an object.\n");
+        return false;
+    }
+
+    if(!parse_vertices(cur))
+        return false;
+
+    cJSON_Delete(json);
+
+    return true;
+}
+
+
+//==============================================================================
+// Parses a single entry of the tiles object and pushes the resulting Tile onto
+// config.tile, followed by its other orientations if it may be rotated or
+// mirrored. Every direction must be covered by exactly one side. Returns
+// boolean success.
+//==============================================================================
+
+bool parse_tile(cJSON *item) {
+    Tile    *tile;
+    Surface  surface;
+    cJSON   *cur;
+    cJSON   *sub;
+    bool     rotate, mirror;
+    int      ndirs = config.dir.used - 1;
+    int      d;
+
+    tile = calloc(1, sizeof(Tile));
+    if(!tile) {
+        printf("Unable to allocate tile.\n");
+        abort();
+    }
+    tile->name = copy_string(item->string);
+
+    tile->side = calloc(ndirs + 1, sizeof(Surface));
+    if(!tile->side) {
+        printf("Unable to allocate tile sides.\n");
+        abort();
+    }
+
+    if(!cJSON_IsObject(item)) {
+        fprintf(stderr, "Malformed tile '%s' in config file, must be an object.\n", tile->name);
+        return false;
+    }
+
+    // tile.sides --------------------------------------------------------------
+
+    cur = cJSON_GetObjectItemCaseSensitive(item, "sides");
+    if(cur == NULL || !cJSON_IsArray(cur)) {
+        fprintf(stderr, "Tile '%s' must have a sides array.\n", tile->name);
+        return false;
+    }
+
+    cJSON_ArrayForEach(sub, cur) {
+        if(!parse_surface(sub, tile->name, &surface))
+            return false;
+        if(tile->side[surface.direction].direction) {
+            fprintf(stderr, "Tile '%s' has more than one side for direction '%s'.\n",
+                tile->name, (char *)config.dir.ary[surface.direction]);
+            return false;
+        }
+        tile->side[surface.direction] = surface;
+    }
+
+    for(d = 1; d <= ndirs; d++) {
+        if(!tile->side[d].direction) {
+            fprintf(stderr, "Tile '%s' has no side for direction '%s'.\n",
+                tile->name, (char *)config.dir.ary[d]);
+            return false;
+        }
+    }
+
+    // tile.spritesheet --------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "spritesheet");
+    if(sub == NULL || !cJSON_IsString(sub)) {
+        fprintf(stderr, "Tile '%s' must have a spritesheet filename.\n", tile->name);
+        return false;
+    }
+    tile->filename = copy_string(sub->valuestring);
+
+    // tile.tileWidth, tile.tileHeight -----------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "tileWidth");
+    if(sub == NULL || !cJSON_IsNumber(sub) || sub->valueint < 1) {
+        fprintf(stderr, "Tile '%s' must have a positive integer tileWidth.\n", tile->name);
+        return false;
+    }
+    tile->width = sub->valueint;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "tileHeight");
+    if(sub == NULL || !cJSON_IsNumber(sub) || sub->valueint < 1) {
+        fprintf(stderr, "Tile '%s' must have a positive integer tileHeight.\n", tile->name);
+        return false;
+    }
+    tile->height = sub->valueint;
+
+    // tile.centerX, tile.centerY (default to the middle of the tile) ----------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "centerX");
+    if(sub == NULL) {
+        tile->x_offset = tile->width / 2;
+    } else if(cJSON_IsNumber(sub)) {
+        tile->x_offset = sub->valueint;
+    } else {
+        fprintf(stderr, "Malformed centerX in tile '%s', must be an integer.\n", tile->name);
+        return false;
+    }
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "centerY");
+    if(sub == NULL) {
+        tile->y_offset = tile->height / 2;
+    } else if(cJSON_IsNumber(sub)) {
+        tile->y_offset = sub->valueint;
+    } else {
+        fprintf(stderr, "Malformed centerY in tile '%s', must be an integer.\n", tile->name);
+        return false;
+    }
+
+    // tile.weight (defaults to 1) ---------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "weight");
+    if(sub == NULL) {
+        tile->weight = 1.0;
+    } else if(cJSON_IsNumber(sub) && sub->valuedouble > 0.0) {
+        tile->weight = sub->valuedouble;
+    } else {
+        fprintf(stderr, "Malformed weight in tile '%s', must be a positive number.\n", tile->name);
+        return false;
+    }
+
+    // tile.minCount, tile.maxCount (default to no limit) ----------------------
+
+    if(!parse_count(item, "minCount", tile->name, &tile->min_count, &tile->min_percent)
+            || !parse_count(item, "maxCount", tile->name, &tile->max_count, &tile->max_percent))
+        return false;
+
+    // tile.rotate, tile.mirror (default to false) -----------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "rotate");
+    if(sub != NULL && !cJSON_IsBool(sub)) {
+        fprintf(stderr, "Malformed rotate in tile '%s', must be a boolean.\n", tile->name);
+        return false;
+    }
+    rotate = cJSON_IsTrue(sub);
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "mirror");
+    if(sub != NULL && !cJSON_IsBool(sub)) {
+        fprintf(stderr, "Malformed mirror in tile '%s', must be a boolean.\n", tile->name);
+        return false;
+    }
+    mirror = cJSON_IsTrue(sub);
+
+    orient_expand(tile, rotate, mirror);
+
+    return true;
+}
+
+
+//==============================================================================
+// Reads an optional count limit from a tile object. The item may be omitted,
+// which leaves *count at COUNT_UNSET, a non-negative integer, or a string
+// holding a percentage of the vertices such as "2.5%". Returns boolean
+// success.
+//==============================================================================
+
+bool parse_count(cJSON *item, char *key, char *tname, double *count, bool *percent) {
+    cJSON *sub;
+    char  *end;
+
+    *count   = COUNT_UNSET;
+    *percent = false;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, key);
+    if(sub == NULL)
+        return true;
+
+    if(cJSON_IsNumber(sub) && sub->valuedouble >= 0 && sub->valuedouble <= INT32_MAX
+            && sub->valuedouble == (int)sub->valuedouble) {
+        *count = sub->valuedouble;
+        return true;
+    }
+    if(cJSON_IsString(sub)) {
+        *count = strtod(sub->valuestring, &end);
+        if(end != sub->valuestring && streq(end, "%") && *count >= 0 && *count <= 100) {
+            *percent = true;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Malformed %s in tile '%s', must be a non-negative integer or a percentage like \"5%%\".\n",
+        key, tname);
+    return false;
+}
+
+
+//==============================================================================
+// Parses the vertices object into config.vert. Vertex names are only used to
+// resolve neighbor references, so they are looked up via sorted NameIndex
+// arrays and then discarded. Neighbor links are made symmetric: if A names B
+// as its neighbor in direction d, B gets A in the opposite direction, and a
+// conflicting entry is an error. Returns boolean success.
+//==============================================================================
+
+bool parse_vertices(cJSON *cur) {
+    NameIndex *vidx;
+    NameIndex *tidx;
+    int32_t   *nbr, *other;
+    cJSON     *sub;
+    int        nverts, ntiles, ndirs = config.dir.used - 1;
+    int        i, d, opp, n;
+
+    nverts = cJSON_GetArraySize(cur);
+    ntiles = config.tile.used;
+
+    vidx = malloc(sizeof(NameIndex) * (nverts + 1));
+    tidx = malloc(sizeof(NameIndex) * (ntiles + 1));
+    if(!vidx || !tidx) {
+        printf("Unable to allocate name index.\n");
+        abort();
+    }
+
+    // First pass: allocate vertices and index their names ---------------------
+
+    vertices_alloc(&config.vert, nverts, ndirs);
+    for(i = 0; i < nverts * ndirs; i++)
+        config.vert.neighbor[i] = -1;
+
+    i = 0;
+    cJSON_ArrayForEach(sub, cur) {
+        config.vert.name[i]        = copy_string(sub->string);
+        config.vert.tile[i]        = -1;
+        config.vert.orientation[i] = 0;
+
+        vidx[i].name  = sub->string;
+        vidx[i].index = i;
+        i++;
+    }
+    qsort(vidx, nverts, sizeof(NameIndex), compare_names);
+
+    for(i = 1; i < nverts; i++) {
+        if(streq(vidx[i - 1].name, vidx[i].name)) {
+            fprintf(stderr, "Duplicate vertex name '%s' in config file.\n", vidx[i].name);
+            return false;
+        }
+    }
+
+    for(i = 0; i < ntiles; i++) {
+        tidx[i].name  = ((Tile *)config.tile.ary[i])->name;
+        tidx[i].index = i;
+    }
+    qsort(tidx, ntiles, sizeof(NameIndex), compare_names);
+
+    // Second pass: parse contents and resolve references ----------------------
+
+    i = 0;
+    cJSON_ArrayForEach(sub, cur) {
+        if(!parse_vertex(sub, i, vidx, tidx))
+            return false;
+        i++;
+    }
+
+    // Make neighbor links symmetric -------------------------------------------
+
+    for(i = 0; i < nverts; i++) {
+        nbr = vertex_neighbors(&config.vert, i);
+        for(d = 1; d <= ndirs; d++) {
+            n = nbr[d - 1];
+            opp = get_opposite_dir(d);
+            if(n < 0 || !opp)
+                continue;
+            other = vertex_neighbors(&config.vert, n);
+            if(other[opp - 1] < 0) {
+                other[opp - 1] = i;
+            } else if(other[opp - 1] != i) {
+                fprintf(stderr, "Inconsistent neighbors: vertex %d is %s of vertex %d, but its %s neighbor is vertex %d.\n",
+                    n, (char *)config.dir.ary[d], i, (char *)config.dir.ary[opp], other[opp - 1]);
+                return false;
+            }
+        }
+    }
+
+    free(vidx);
+    free(tidx);
+
+    return true;
+}
+
+
+//==============================================================================
+// Parses entry v of the vertices object, resolving neighbor and tile names
+// through the supplied indices. Vertices must be parsed in order, since each
+// one's eligible tiles are appended to config.vert.elig. Returns boolean
+// success.
+//==============================================================================
+
+bool parse_vertex(cJSON *item, int v, NameIndex *vidx, NameIndex *tidx) {
+    cJSON   *cur;
+    cJSON   *sub;
+    Tile    *tile;
+    int32_t *nbr = vertex_neighbors(&config.vert, v);
+    char    *vname = item->string;
+    int      nverts = config.vert.used;
+    int      ntiles = config.tile.used;
+    int      i, j, t, d, cnt;
+
+    if(!cJSON_IsObject(item)) {
+        fprintf(stderr, "Malformed vertex '%s' in config file, must be an object.\n", vname);
+        return false;
+    }
+
+    // vertex.order ------------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "order");
+    if(sub == NULL || !cJSON_IsNumber(sub)) {
+        fprintf(stderr, "Vertex '%s' must have an integer order.\n", vname);
+        return false;
+    }
+    config.vert.order[v] = sub->valueint;
+
+    // vertex.eligibleTiles ----------------------------------------------------
+
+    i = config.vert.elig_start[v];
+    cur = cJSON_GetObjectItemCaseSensitive(item, "eligibleTiles");
+    if(cur != NULL && !cJSON_IsNull(cur)) {
+        if(!cJSON_IsArray(cur)) {
+            fprintf(stderr, "Malformed eligibleTiles in vertex '%s', must be an array or null.\n", vname);
+            return false;
+        }
+        if(!cJSON_GetArraySize(cur)) {
+            fprintf(stderr, "Vertex '%s' has an empty eligibleTiles list.\n", vname);
+            return false;
+        }
+        cnt = 0;
+        cJSON_ArrayForEach(sub, cur) {
+            if(!cJSON_IsString(sub) || (t = find_name(tidx, ntiles, sub->valuestring)) < 0) {
+                fprintf(stderr, "Vertex '%s' lists an unknown eligible tile.\n", vname);
+                return false;
+            }
+            tile = config.tile.ary[t];
+            cnt += tile->master == t ? tile->variants : 1;
+        }
+        vertices_reserve_eligible(&config.vert, i + cnt);
+
+        // A tile's plain name stands for all of its orientations.
+
+        cJSON_ArrayForEach(sub, cur) {
+            t = find_name(tidx, ntiles, sub->valuestring);
+            tile = config.tile.ary[t];
+            for(j = 0; j < (tile->master == t ? tile->variants : 1); j++)
+                config.vert.elig[i++] = t + j;
+        }
+    }
+    config.vert.elig_start[v + 1] = i;
+
+    // vertex.neighbors --------------------------------------------------------
+
+    cur = cJSON_GetObjectItemCaseSensitive(item, "neighbors");
+    if(cur != NULL) {
+        if(!cJSON_IsObject(cur)) {
+            fprintf(stderr, "Malformed neighbors in vertex '%s', must be an object.\n", vname);
+            return false;
+        }
+        cJSON_ArrayForEach(sub, cur) {
+            d = get_dir_offset(sub->string);
+            if(!d) {
+                fprintf(stderr, "Vertex '%s' has a neighbor in unknown direction '%s'.\n", vname, sub->string);
+                return false;
+            }
+            if(cJSON_IsNull(sub))
+                continue;
+            if(!cJSON_IsString(sub)
+                    || (nbr[d - 1] = find_name(vidx, nverts, sub->valuestring)) < 0) {
+                fprintf(stderr, "Vertex '%s' has an unknown %s neighbor.\n", vname, sub->string);
+                return false;
+            }
+        }
+    }
+
+    // vertex.centerX, vertex.centerY ------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "centerX");
+    if(sub == NULL || !cJSON_IsNumber(sub)) {
+        fprintf(stderr, "Vertex '%s' must have an integer centerX.\n", vname);
+        return false;
+    }
+    config.vert.x[v] = sub->valueint;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "centerY");
+    if(sub == NULL || !cJSON_IsNumber(sub)) {
+        fprintf(stderr, "Vertex '%s' must have an integer centerY.\n", vname);
+        return false;
+    }
+    config.vert.y[v] = sub->valueint;
+
+    return true;
+}
+
+
+//==============================================================================
+// Parses a single element of a tile's sides array into the supplied Surface.
+// Omitted flags and masks default to false/0. Returns boolean success.
+//==============================================================================
+
+bool parse_surface(cJSON *item, char *tname, Surface *surface) {
+    cJSON *sub;
+    cJSON *lbl;
+    int    i, cnt;
+
+    memset(surface, 0, sizeof(Surface));
+
+    if(!cJSON_IsObject(item)) {
+        fprintf(stderr, "Malformed side in tile '%s', must be an object.\n", tname);
+        return false;
+    }
+
+    // side.direction ----------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "direction");
+    if(sub == NULL || !cJSON_IsString(sub)) {
+        fprintf(stderr, "Side in tile '%s' is missing its direction.\n", tname);
+        return false;
+    }
+    surface->direction = get_dir_offset(sub->valuestring);
+    if(!surface->direction) {
+        fprintf(stderr, "Side in tile '%s' has unknown direction '%s'.\n", tname, sub->valuestring);
+        return false;
+    }
+
+    // side.label --------------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "label");
+    if(sub != NULL) {
+        if(!cJSON_IsNumber(sub) || sub->valuedouble < 0 || sub->valuedouble > UINT32_MAX) {
+            fprintf(stderr, "Malformed label in tile '%s', must be an unsigned 32-bit integer.\n", tname);
+            return false;
+        }
+        surface->label = (uint32_t)sub->valuedouble;
+    }
+
+    // side.matchAny, side.endcap ----------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "matchAny");
+    if(sub != NULL) {
+        if(!cJSON_IsBool(sub)) {
+            fprintf(stderr, "Malformed matchAny in tile '%s', must be a boolean.\n", tname);
+            return false;
+        }
+        surface->match_any = cJSON_IsTrue(sub);
+    }
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "endcap");
+    if(sub != NULL) {
+        if(!cJSON_IsBool(sub)) {
+            fprintf(stderr, "Malformed endcap in tile '%s', must be a boolean.\n", tname);
+            return false;
+        }
+        surface->endcap = cJSON_IsTrue(sub);
+    }
+
+    // side.matchLabels --------------------------------------------------------
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, "matchLabels");
+    if(sub != NULL && !cJSON_IsFalse(sub)) {
+        if(!cJSON_IsArray(sub)) {
+            fprintf(stderr, "Malformed matchLabels in tile '%s', must be an array or false.\n", tname);
+            return false;
+        }
+        cnt = cJSON_GetArraySize(sub);
+        surface->labels = calloc(cnt + 1, sizeof(uint32_t));
+        if(!surface->labels) {
+            printf("Unable to allocate label list.\n");
+            abort();
+        }
+        for(i = 0; i < cnt; i++) {
+            lbl = cJSON_GetArrayItem(sub, i);
+            if(!cJSON_IsNumber(lbl) || lbl->valuedouble < 1 || lbl->valuedouble > UINT32_MAX) {
+                fprintf(stderr, "Malformed matchLabels in tile '%s', labels must be positive 32-bit integers.\n", tname);
+                return false;
+            }
+            surface->labels[i] = (uint32_t)lbl->valuedouble;
+        }
+        surface->match_labels = true;
+    }
+
+    // side.matchAnyOf, side.matchAllOf, side.matchNoneOf ----------------------
+
+    if(!parse_mask(item, "matchAnyOf", tname, &surface->any_of))
+        return false;
+    if(!parse_mask(item, "matchAllOf", tname, &surface->all_of))
+        return false;
+    if(!parse_mask(item, "matchNoneOf", tname, &surface->none_of))
+        return false;
+
+    return true;
+}
+
+
+//==============================================================================
+// Reads an optional bitmask item from a side object. The item may be omitted,
+// false, or an unsigned 32-bit integer; the first two leave the mask at 0,
+// which disables it. Returns boolean success.
+//==============================================================================
+
+bool parse_mask(cJSON *item, char *key, char *tname, uint32_t *mask) {
+    cJSON *sub;
+
+    sub = cJSON_GetObjectItemCaseSensitive(item, key);
+    if(sub == NULL || cJSON_IsFalse(sub))
+        return true;
+
+    if(!cJSON_IsNumber(sub) || sub->valuedouble < 0 || sub->valuedouble > UINT32_MAX) {
+        fprintf(stderr, "Malformed %s in tile '%s', must be a 32-bit bitmask or false.\n", key, tname);
+        return false;
+    }
+    *mask = (uint32_t)sub->valuedouble;
+
+    return true;
 }
 
 
@@ -268,23 +1239,64 @@ bool parse_config(char *fname) {
 //==============================================================================
 
 int get_dir_offset(char *name) {
-    int i;
+    int i, ndirs = config.dir.used - 1;
 
-    for(i = 1; i <= Config.dir.used; i++) {
-        if(streqn(config.dir.ary[i], name))
+    for(i = 1; i <= ndirs; i++) {
+        if(streq(config.dir.ary[i], name))
             return i;
     }
     return 0;
 }
 
 
+//==============================================================================
+// Looks up name in a NameIndex array sorted with compare_names(). Returns the
+// associated index or -1 if not found.
+//==============================================================================
+
+int find_name(NameIndex *idx, int cnt, char *name) {
+    NameIndex  key;
+    NameIndex *res;
+
+    key.name = name;
+    res = bsearch(&key, idx, cnt, sizeof(NameIndex), compare_names);
+
+    return res ? res->index : -1;
+}
+
+
+//==============================================================================
+// qsort/bsearch comparator for NameIndex entries.
+//==============================================================================
+
+int compare_names(const void *a, const void *b) {
+    return strcmp(((NameIndex *)a)->name, ((NameIndex *)b)->name);
+}
+
+
+//==============================================================================
+// Given a direction offset, returns the offset of the direction pointing the
+// opposite way. Since the directions are assumed to be clockwise, this is the
+// direction halfway around the list. Returns 0 if the number of directions is
+// odd and there is therefore no opposite.
+//==============================================================================
+
+int get_opposite_dir(int dir) {
+    int ndirs = config.dir.used - 1;
+
+    if(ndirs % 2)
+        return 0;
+    return ((dir - 1 + ndirs / 2) % ndirs) + 1;
+}
+
+
 //==============================================================================
 // Given a string of the form "#xxxxxx", sets the corresponding RGB values in
 // the Pixel.
 //==============================================================================
 
 void parse_hex_triplet(char *triplet, Pixel *p) {
-    char buf[3] = { ' ', ' ', '\0');
+    char buf[3] = { ' ', ' ', '\0' };
 
     buf[0] = triplet[1];
     buf[1] = triplet[2];
@@ -314,26 +1326,48 @@ char *load_file(char *fname) {
     size_t bytes_read;
     size_t bufsize = 0xFFFF;
 
-    buf = malloc(bufsize)
+    buf = malloc(bufsize + 1);
     if(!buf)
         return NULL;
 
     fp = fopen(fname, "r");
-    if(!fp)
+    if(!fp) {
+        free(buf);
         return NULL;
+    }
 
     bytes_read = fread(buf, sizeof(char), bufsize, fp);
-    while(feof(fp)) {
+    while(!feof(fp) && !ferror(fp)) {
         bufsize *= 2;
-        buf = realloc(buf, bufsize);
-        bytes_read += fread(buf + bytes_read, sizeof(char), bufsize / 2, fp);
+        buf = realloc(buf, bufsize + 1);
+        bytes_read += fread(buf + bytes_read, sizeof(char), bufsize - bytes_read, fp);
     }
     fclose(fp);
+    buf[bytes_read] = '\0';
 
     return buf;
 }
 
 
+//==============================================================================
+// Returns a dynamically allocated copy of the supplied string. Aborts if the
+// allocation fails.
+//==============================================================================
+
+char *copy_string(char *str) {
+    char *newstr;
+
+    newstr = malloc(strlen(str) + 1);
+    if(!newstr) {
+        printf("Unable to allocate string.\n");
+        abort();
+    }
+    strcpy(newstr, str);
+
+    return newstr;
+}
+
+
 //==============================================================================
 // Returns a boolean indicating whether all of the line was read into the
 // buffer or not, i.e., it ends in a newline.
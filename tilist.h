@@ -11,6 +11,9 @@
 #include "dynarray.h"
 #include "lodepng/lodepng.h"
 #include "cJSON.h"
+#include "vertex.h"
+
+#define NEIGHBOR_OPEN -2    // Vertices.neighbor: the side faces a vertex that is not loaded
 
 
 typedef struct {    // Generic RGBA pixel type
@@ -20,34 +23,35 @@ typedef struct {    // Generic RGBA pixel type
     uint8_t a;
 } Pixel;
 
+typedef struct {    // Decoded RGBA image
+    Pixel    *pixels;
+    unsigned  width;
+    unsigned  height;
+} Bitmap;
+
 struct Config {                   // global config structure
     Dynarray  dir;                  // direction array
-    Dynarray  vert;                 // vertex array
+    Vertices  vert;                 // vertex arrays
     Dynarray  tile;                 // tile master array
     int       image_width;
     int       image_height;
     Pixel     bgcolor;
     char     *bg_image_filename;
     char     *output_png_name;
+    int       threads;              // threads for parallel setup work, e.g., lattice generation
+    int       band;                 // rows per band when streaming a lattice, 0 to load it whole
 };
 
-typedef struct {         // Definition of lattice vertices
-    int order;               // order in which vertices are visited
-    int *eligible;           // array of eligible tiles or NULL for all
-    int *neighbor;           // array of neighbors by direction, offset matches config.dir.ary
-    int tile;                // index of tile master
-    int orientation;         // index of orientation
-    int x_offset;            // x coord in rendered graphic
-    int y_offset;            // y coord in rendered graphic
-} Vertex;
-
 typedef struct {             // Definition of mating surface/side
-    bool      direction;         // offset into config.dir.ary
+    int       direction;         // offset into config.dir.ary
     bool      match_any;         // if true, matches any tile
     bool      endcap;            // if true, can match no tile
     bool      match_labels;      // if true, matches any label in labels
     uint32_t  label;             // label for this surface
     uint32_t *labels;            // if not NULL, a null-terminated array of matching labels
+    int       label_id;          // dense ID of label, see label.h
+    uint64_t *accept;            // bitset over label IDs that this surface accepts, NULL if it
+                                 // matches anything or only its own label
     uint32_t  any_of;            // if match_any_of is true, will match any 1 bit in this bitmask
     uint32_t  all_of;            // if match_all_of is true, must match all 1 bits in this bitmask
     uint32_t  none_of;           // if match_none_of is true, must not match any 1 bit in this bitmask
@@ -59,19 +63,45 @@ typedef struct {         // Definition of tile masters
     char *filename;          // path to sprite sheet
     int width;               // width of sprite sheet
     int height;              // height of sprite sheet
-    // TODO: bitmap
+    double weight;           // relative frequency when tiles are picked at random
+    double min_count;        // fewest vertices that must hold the tile, COUNT_UNSET if
+                             // unlimited; see count.h
+    double max_count;        // most vertices that may hold it, COUNT_UNSET if unlimited
+    bool min_percent;        // min_count is a percentage of the vertices
+    bool max_percent;        // max_count is a percentage of the vertices
+    int master;              // offset of the tile as defined in the config, see orient.h
+    int orientation;         // index of orientation, i.e., of the frame in the sprite sheet
+    int variants;            // number of distinct orientations, stored from master on
+    Bitmap *sprite;          // decoded sprite sheet, shared by tiles with the same filename
     int x_offset;            // x coord of tile center
     int y_offset;            // y coord of tile center
 } Tile;
 
+typedef struct {         // Name lookup entry used while resolving references
+    char *name;              // name as it appears in the config file
+    int index;               // offset into the corresponding Dynarray
+} NameIndex;
+
+extern struct Config config;
+
 
 // Prototypes ==================================================================
 
+int   compare_names(const void *a, const void *b);
+char *copy_string(char *str);
+int   find_name(NameIndex *idx, int cnt, char *name);
 int   get_dir_offset(char *name);
+int   get_opposite_dir(int dir);
 bool  init(char *fname);
-char *load_file(char *fname)
+char *load_file(char *fname);
 bool  parse_config(char *fname);
+bool  parse_count(cJSON *item, char *key, char *tname, double *count, bool *percent);
 void  parse_hex_triplet(char *triplet, Pixel *p);
+bool  parse_mask(cJSON *item, char *key, char *tname, uint32_t *mask);
+bool  parse_surface(cJSON *item, char *tname, Surface *surface);
+bool  parse_tile(cJSON *item);
+bool  parse_vertex(cJSON *item, int v, NameIndex *vidx, NameIndex *tidx);
+bool  parse_vertices(cJSON *cur);
 bool  partial_line(char *line);
 bool  streq(char *a, char *b);
 bool  streqn(char *a, char *b, int n);
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vertex.h"
+
+//##############################################################################
+//# Structure-of-arrays vertex storage.
+//##############################################################################
+
+
+//==============================================================================
+// Makes room for n vertices with ndirs neighbor slots each and sets vs->used
+// to n. Previous contents are discarded unless the arrays were already large
+// enough. Every vertex starts out with an empty eligible list; the other
+// attributes are left for the caller to fill in.
+//==============================================================================
+
+void vertices_alloc(Vertices *vs, int n, int ndirs) {
+    if(n > vs->size || ndirs != vs->ndirs) {
+        free(vs->name);
+        free(vs->order);
+        free(vs->tile);
+        free(vs->orientation);
+        free(vs->x);
+        free(vs->y);
+        free(vs->neighbor);
+        free(vs->elig_start);
+
+        vs->size        = n > vs->size ? n : vs->size;
+        vs->ndirs       = ndirs;
+        vs->name        = malloc(sizeof(char *) * vs->size);
+        vs->order       = malloc(sizeof(int) * vs->size);
+        vs->tile        = malloc(sizeof(int) * vs->size);
+        vs->orientation = malloc(sizeof(int) * vs->size);
+        vs->x           = malloc(sizeof(int) * vs->size);
+        vs->y           = malloc(sizeof(int) * vs->size);
+        vs->neighbor    = malloc(sizeof(int32_t) * (size_t)vs->size * (ndirs ? ndirs : 1));
+        vs->elig_start  = malloc(sizeof(int) * (vs->size + 1));
+        if(!vs->name || !vs->order || !vs->tile || !vs->orientation || !vs->x || !vs->y
+                || !vs->neighbor || !vs->elig_start) {
+            printf("Unable to allocate vertices.\n");
+            abort();
+        }
+    }
+
+    vs->used = n;
+    memset(vs->elig_start, 0, sizeof(int) * (n + 1));
+}
+
+
+//==============================================================================
+// Releases the storage of vs. Names are owned by whoever set them.
+//==============================================================================
+
+void vertices_free(Vertices *vs) {
+    free(vs->name);
+    free(vs->order);
+    free(vs->tile);
+    free(vs->orientation);
+    free(vs->x);
+    free(vs->y);
+    free(vs->neighbor);
+    free(vs->elig_start);
+    free(vs->elig);
+    memset(vs, 0, sizeof(Vertices));
+}
+
+
+//==============================================================================
+// Makes sure that vs->elig has room for n entries, keeping its contents.
+//==============================================================================
+
+void vertices_reserve_eligible(Vertices *vs, int n) {
+    int *elig;
+
+    if(n <= vs->elig_size)
+        return;
+    if(n < vs->elig_size * 2)
+        n = vs->elig_size * 2;
+
+    elig = realloc(vs->elig, sizeof(int) * n);
+    if(!elig) {
+        printf("Unable to allocate eligible tile lists.\n");
+        abort();
+    }
+    vs->elig      = elig;
+    vs->elig_size = n;
+}
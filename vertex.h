@@ -0,0 +1,61 @@
+#ifndef VERTEX_H
+#define VERTEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//##############################################################################
+//# Vertex storage as a structure of arrays, each indexed by vertex, so that a
+//# lattice of a million vertices takes a handful of allocations rather than
+//# millions and a pass over one attribute reads memory in order. Neighbors form
+//# a dense used x ndirs matrix: the neighbor of vertex v in direction d is at
+//# neighbor[v * ndirs + d - 1]. Eligible tile lists are stored back to back in
+//# compressed sparse row form: vertex v may take the tiles in elig[] from
+//# elig_start[v] up to elig_start[v + 1], and an empty range means any tile.
+//##############################################################################
+
+typedef struct {
+    int       used;          // number of vertices
+    int       size;          // vertices the arrays have room for
+    int       ndirs;         // neighbor slots per vertex, i.e., config.dir.used - 1
+    char    **name;          // name as it appears in the config file
+    int      *order;         // order in which vertices are visited
+    int      *tile;          // index of tile, -1 if unassigned
+    int      *orientation;   // orientation of the tile, see Tile.orientation
+    int      *x;             // x coord in rendered graphic
+    int      *y;             // y coord in rendered graphic
+    int32_t  *neighbor;      // used * ndirs neighbors, -1 for none or NEIGHBOR_OPEN for
+                             // one that exists but is not loaded
+    int      *elig_start;    // used + 1 offsets into elig
+    int      *elig;          // eligible tiles of every vertex, in vertex order
+    int       elig_size;     // entries elig has room for
+} Vertices;
+
+
+//==============================================================================
+// Returns the neighbors of vertex v, indexed by direction - 1.
+//==============================================================================
+
+static inline int32_t *vertex_neighbors(Vertices *vs, int v) {
+    return vs->neighbor + (size_t)v * vs->ndirs;
+}
+
+
+//==============================================================================
+// Returns the eligible tiles of vertex v and stores their number in cnt, which
+// is 0 if the vertex may take any tile.
+//==============================================================================
+
+static inline int *vertex_eligible(Vertices *vs, int v, int *cnt) {
+    *cnt = vs->elig_start[v + 1] - vs->elig_start[v];
+    return vs->elig + vs->elig_start[v];
+}
+
+
+// Prototypes ==================================================================
+
+void vertices_alloc(Vertices *vs, int n, int ndirs);
+void vertices_free(Vertices *vs);
+void vertices_reserve_eligible(Vertices *vs, int n);
+
+#endif // VERTEX_H
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "workpool.h"
+
+//##############################################################################
+//# Minimal worker pool.
+//##############################################################################
+
+
+//==============================================================================
+// Runs fn(job, ctx) for every job in 0..njobs-1 on up to nthreads threads and
+// returns when all of them are done. Jobs are handed out in order, but may
+// finish in any order. With one thread, everything runs on the caller.
+//==============================================================================
+
+void workpool_run(int nthreads, int njobs, WorkFunc fn, void *ctx) {
+    WorkPool   pool;
+    pthread_t *threads;
+    int        i;
+
+    pool.fn    = fn;
+    pool.ctx   = ctx;
+    pool.njobs = njobs;
+    pool.next  = 0;
+
+    if(nthreads > njobs)
+        nthreads = njobs;
+    if(nthreads <= 1) {
+        workpool_thread(&pool);
+        return;
+    }
+
+    threads = malloc(sizeof(pthread_t) * nthreads);
+    if(!threads) {
+        printf("Unable to allocate worker threads.\n");
+        abort();
+    }
+
+    for(i = 0; i < nthreads; i++) {
+        if(pthread_create(threads + i, NULL, workpool_thread, &pool)) {
+            printf("Unable to start worker thread %d.\n", i);
+            abort();
+        }
+    }
+    for(i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+}
+
+
+//==============================================================================
+// Thread body: claims and runs jobs until none are left.
+//==============================================================================
+
+void *workpool_thread(void *arg) {
+    WorkPool *pool = arg;
+    int       job;
+
+    while((job = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->njobs)
+        pool->fn(job, pool->ctx);
+
+    return NULL;
+}
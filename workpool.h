@@ -0,0 +1,26 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <pthread.h>
+
+//##############################################################################
+//# Minimal worker pool: a fixed number of threads pull job numbers from a
+//# shared counter until all jobs have been handed out.
+//##############################################################################
+
+typedef void (*WorkFunc)(int job, void *ctx);
+
+typedef struct {
+    WorkFunc  fn;            // called once per job
+    void     *ctx;           // passed through to fn
+    int       njobs;         // jobs are numbered 0..njobs-1
+    int       next;          // next job to hand out
+} WorkPool;
+
+
+// Prototypes ==================================================================
+
+void  workpool_run(int nthreads, int njobs, WorkFunc fn, void *ctx);
+void *workpool_thread(void *arg);
+
+#endif // WORKPOOL_H